@@ -0,0 +1,58 @@
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "CsvExport.h"
+
+namespace
+{
+    /// In-memory database with the tables the exporters read, holding rows events and logs.
+    void Populate(sqlite::database &db, int64_t rows)
+    {
+        db << "CREATE TABLE module_capabilities (module_id TEXT, module_name TEXT, module_guid TEXT)";
+        db << "CREATE TABLE events (source TEXT, topic TEXT, tick INTEGER, timestamp INTEGER, data TEXT)";
+        db << "CREATE TABLE logs (module_name TEXT, module_guid TEXT, module_id TEXT, message TEXT, "
+              "log_level TEXT, timestamp INTEGER)";
+
+        db << "BEGIN";
+        for (int module = 0; module < 8; ++module)
+        {
+            db << "INSERT INTO module_capabilities VALUES (?, ?, ?)" << std::to_string(module)
+               << "Module_" + std::to_string(module) << "guid-" + std::to_string(module);
+        }
+        for (int64_t i = 0; i < rows; ++i)
+        {
+            std::string guid = "guid-" + std::to_string(i % 8);
+            db << "INSERT INTO events VALUES (?, ?, ?, ?, ?)" << guid << "AMM::RenderModification" << i
+               << 1600000000 + i << "<RenderModification type=\"CONNECT_ECG\"/>";
+            db << "INSERT INTO logs VALUES (?, ?, ?, ?, ?, ?)" << "Module_" + std::to_string(i % 8) << guid
+               << std::to_string(i % 8) << "Heartbeat received from the module manager" << "INFO"
+               << 1600000000 + i;
+        }
+        db << "COMMIT";
+    }
+}
+
+static void BM_EventLogCsv(benchmark::State &state)
+{
+    sqlite::database db(":memory:");
+    Populate(db, state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(EventLogCsv(db));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EventLogCsv)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+static void BM_DiagnosticLogCsv(benchmark::State &state)
+{
+    sqlite::database db(":memory:");
+    Populate(db, state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(DiagnosticLogCsv(db));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DiagnosticLogCsv)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
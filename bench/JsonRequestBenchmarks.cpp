@@ -0,0 +1,124 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "JsonRequest.h"
+
+#if defined(__GLIBC__)
+// Counts heap allocations made by the whole process, so the benchmarks can report how
+// many a request costs once the calling thread's parse arena is warm.
+extern "C" void *__libc_malloc(std::size_t size);
+extern "C" void *__libc_calloc(std::size_t count, std::size_t size);
+extern "C" void *__libc_realloc(void *ptr, std::size_t size);
+
+namespace
+{
+    std::atomic<uint64_t> heapAllocations{0};
+}
+
+extern "C" void *malloc(std::size_t size) noexcept
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(std::size_t count, std::size_t size) noexcept
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, std::size_t size) noexcept
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+namespace
+{
+    uint64_t HeapAllocations()
+    {
+#if defined(__GLIBC__)
+        return heapAllocations.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    const std::string CommandBody = R"({"payload":"[SYS]START_SIM"})";
+
+    const std::string BatchBody =
+        R"([{"op":"command","payload":"[ACT]PGO_TRAINING"},)"
+        R"({"op":"physiology_modification","type":"Hemorrhage","location":"LeftLeg","payload":"<Flow>0.5</Flow>"},)"
+        R"({"op":"render_modification","type":"CONNECT_ECG","payload":"<RenderModification/>"},)"
+        R"({"op":"performance_assessment","type":"CPR","info":"compressions","step":"1","comment":"ok"}])";
+
+    /// Parses, validates and extracts one body the way the handlers do. The arena is
+    /// warmed up first; "allocs" is the heap allocations per request after that.
+    void ParseBody(benchmark::State &state, const std::string &body, RequestKind kind)
+    {
+        static bool compiled = (JsonRequest::CompileSchemas(), true);
+        benchmark::DoNotOptimize(compiled);
+
+        std::string error;
+        OperationFields fields;
+        auto parse = [&]()
+        {
+            const rapidjson::Value *root = JsonRequest::Parse(body, kind, error);
+            if (root == nullptr)
+            {
+                return false;
+            }
+            if (kind != RequestKind::Batch)
+            {
+                return JsonRequest::Extract(*root, kind, fields, error);
+            }
+            for (rapidjson::SizeType i = 0; i < root->Size(); ++i)
+            {
+                if (!JsonRequest::Extract((*root)[i], kind, fields, error))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for (int i = 0; i < 100; ++i)
+        {
+            parse();
+        }
+
+        uint64_t before = HeapAllocations();
+        for (auto _ : state)
+        {
+            if (!parse())
+            {
+                state.SkipWithError(error.c_str());
+                break;
+            }
+            benchmark::DoNotOptimize(fields.payload.data());
+        }
+        state.counters["allocs"] = benchmark::Counter(static_cast<double>(HeapAllocations() - before),
+                                                      benchmark::Counter::kAvgIterations);
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(body.size()));
+    }
+}
+
+/// A /execute body. Both parse benchmarks run a fixed 10k requests, so "allocs" covers
+/// the same number of requests on every run.
+static void BM_ParseCommand(benchmark::State &state)
+{
+    ParseBody(state, CommandBody, RequestKind::Command);
+}
+BENCHMARK(BM_ParseCommand)->Iterations(10000);
+
+/// A /batch body with one item of every operation.
+static void BM_ParseBatch(benchmark::State &state)
+{
+    ParseBody(state, BatchBody, RequestKind::Batch);
+}
+BENCHMARK(BM_ParseBatch)->Iterations(10000);
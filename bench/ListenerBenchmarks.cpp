@@ -0,0 +1,124 @@
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "NodeData.h"
+#include "RESTListener.h"
+
+namespace
+{
+    std::vector<std::string> NodeNames(int count)
+    {
+        std::vector<std::string> names;
+        names.reserve(count);
+        for (int i = 0; i < count; ++i)
+        {
+            names.push_back("Cardiovascular_Node_" + std::to_string(i));
+        }
+        return names;
+    }
+
+    AMM::Status MakeStatus(const std::string &module, const std::string &capability, const std::string &message)
+    {
+        AMM::Status st;
+        st.module_name(module);
+        st.capability(capability);
+        st.message(message);
+        st.value(AMM::StatusValue::OPERATIONAL);
+        return st;
+    }
+}
+
+/// One physiology sample staged into a table of state.range(0) nodes, as the engine
+/// publishes them. The per-tick commit is measured by BM_CommitTick.
+static void BM_OnNewPhysiologyValue(benchmark::State &state)
+{
+    nodeStore.clear();
+    std::vector<std::string> names = NodeNames(static_cast<int>(state.range(0)));
+    RESTListener listener;
+    AMM::PhysiologyValue value;
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        value.name(names[next]);
+        value.value(static_cast<double>(next));
+        listener.onNewPhysiologyValue(value, nullptr);
+        next = next + 1 == names.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OnNewPhysiologyValue)->Arg(100)->Arg(1000)->Arg(10000);
+
+/// Status dispatch over a mix of matched and unmatched module/capability pairs, one of
+/// them with a message that is not a number.
+static void BM_OnNewStatus(benchmark::State &state)
+{
+    std::vector<AMM::Status> statuses = {
+        MakeStatus("AMM_FluidManager", "air_supply", "14.7"),
+        MakeStatus("AMM_FluidManager", "fluidics", ""),
+        MakeStatus("Torso_Control", "blood_supply", ""),
+        MakeStatus("AJAMS_Services", "battery-1", "87"),
+        MakeStatus("AJAMS_Services", "battery-2", "n/a"),
+        MakeStatus("AJAMS_Services", "ext_power", ""),
+        MakeStatus("IVArm", "iv_detection", ""),
+        MakeStatus("AMM_Module_Manager", "module_manager", ""),
+    };
+    RESTListener listener;
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        listener.onNewStatus(statuses[next], nullptr);
+        next = next + 1 == statuses.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OnNewStatus);
+
+/// Render modification dispatch; the unknown type walks the whole comparison chain.
+static void BM_OnNewRenderModification(benchmark::State &state)
+{
+    std::vector<std::string> types = {"CONNECT_ECG", "DETACH_TEMP_PROBE", "ATTACH_TO_PATIENT",
+                                      "DETACH_FROM_PATIENT", "PATIENT_VOMIT"};
+    std::vector<AMM::RenderModification> mods(types.size());
+    for (std::size_t i = 0; i < types.size(); ++i)
+    {
+        mods[i].type(types[i]);
+        mods[i].data("<RenderModification type=\"" + types[i] + "\"/>");
+    }
+    RESTListener listener;
+    std::size_t next = 0;
+    for (auto _ : state)
+    {
+        listener.onNewRenderModification(mods[next], nullptr);
+        next = next + 1 == mods.size() ? 0 : next + 1;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OnNewRenderModification);
+
+/// One lab report row built from a populated node table.
+static void BM_AppendLabRow(benchmark::State &state)
+{
+    nodeStore.clear();
+    for (const std::string &name : NodeNames(1000))
+    {
+        nodeStore.set(name, 1.0);
+    }
+    nodeStore.commit(1, 0.02);
+    ResetLabs();
+    AppendLabRow();
+    for (auto _ : state)
+    {
+        AppendLabRow();
+        if (labsStorage.size() > 4096)
+        {
+            state.PauseTiming();
+            ResetLabs();
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    ResetLabs();
+}
+BENCHMARK(BM_AppendLabRow);
@@ -0,0 +1,109 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "NodeData.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+/// /nodes serialization at state.range(0) nodes plus the status entries.
+static void BM_WriteNodes(benchmark::State &state)
+{
+    nodeStore.clear();
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        nodeStore.set("Cardiovascular_Node_" + std::to_string(i), 72.0 + static_cast<double>(i) / 7.0);
+    }
+    nodeStore.commit(1, 0.02);
+
+    rapidjson::StringBuffer buffer;
+    for (auto _ : state)
+    {
+        std::shared_ptr<const NodeStore::Snapshot> nodes = nodeStore.snapshot();
+        buffer.Clear();
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        WriteNodes(writer, *nodes);
+        benchmark::DoNotOptimize(buffer.GetString());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(buffer.GetSize()));
+    state.counters["bytes"] = static_cast<double>(buffer.GetSize());
+    nodeStore.clear();
+}
+BENCHMARK(BM_WriteNodes)->Arg(100)->Arg(1000)->Arg(10000);
+
+/// Publishing one frame of state.range(0) nodes, all of them updated since the last tick.
+static void BM_CommitTick(benchmark::State &state)
+{
+    nodeStore.clear();
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        names.push_back("Cardiovascular_Node_" + std::to_string(i));
+    }
+    int64_t frame = 0;
+    for (auto _ : state)
+    {
+        for (const std::string &name : names)
+        {
+            nodeStore.set(name, static_cast<double>(frame));
+        }
+        ++frame;
+        nodeStore.commit(frame, static_cast<double>(frame) / 50.0);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    nodeStore.clear();
+}
+BENCHMARK(BM_CommitTick)->Arg(100)->Arg(1000)->Arg(10000);
+
+/// A frame of state.range(0) nodes that jitter in the sixth decimal, with a relative
+/// deadband (state.range(1) = 1) or without. With the deadband the commits publish nothing.
+static void BM_CommitTickJitter(benchmark::State &state)
+{
+    NodeStore store;
+    if (state.range(1) != 0)
+    {
+        Deadbands deadbands;
+        Deadband band;
+        band.relative = 0.0001;
+        deadbands.setDefault(band);
+        store.setDeadbands(deadbands);
+    }
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        names.push_back("Cardiovascular_Node_" + std::to_string(i));
+    }
+    int64_t frame = 0;
+    for (auto _ : state)
+    {
+        double jitter = (frame % 2) * 0.000001;
+        for (const std::string &name : names)
+        {
+            store.set(name, 72.0 + jitter);
+        }
+        ++frame;
+        store.commit(frame, static_cast<double>(frame) / 50.0);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["suppressed"] = static_cast<double>(store.suppressed());
+}
+BENCHMARK(BM_CommitTickJitter)->Args({1000, 0})->Args({1000, 1});
+
+/// /labs report of state.range(0) rows.
+static void BM_LabsReport(benchmark::State &state)
+{
+    ResetLabs();
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        AppendLabRow();
+    }
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(LabsReport());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    ResetLabs();
+}
+BENCHMARK(BM_LabsReport)->Arg(10)->Arg(100);
@@ -0,0 +1,56 @@
+#include <cmath>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "WaveformStore.h"
+
+/// Min/max decimation of a full ring by state.range(0) samples per pair.
+static void BM_DecimateMinMax(benchmark::State &state)
+{
+    std::size_t factor = static_cast<std::size_t>(state.range(0));
+    std::vector<float> samples(WaveformRing::Capacity);
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+        samples[i] = static_cast<float>(std::sin(static_cast<double>(i) / 40.0));
+    }
+    std::vector<float> out(2 * (samples.size() / factor));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(DecimateMinMax(samples.data(), samples.size(), factor, out.data()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(samples.size()));
+}
+BENCHMARK(BM_DecimateMinMax)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+/// The listener's cost per waveform sample.
+static void BM_WaveformPush(benchmark::State &state)
+{
+    WaveformStore store;
+    float value = 0.0f;
+    for (auto _ : state)
+    {
+        store.push("ECG_Lead_II", "mV", value);
+        value += 0.001f;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_WaveformPush);
+
+/// Copying a full ring out for a /waveform request.
+static void BM_WaveformRead(benchmark::State &state)
+{
+    WaveformRing ring;
+    for (std::size_t i = 0; i < WaveformRing::Capacity; ++i)
+    {
+        ring.push(static_cast<float>(i));
+    }
+    std::vector<float> samples;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(ring.read(0, samples));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(WaveformRing::Capacity));
+}
+BENCHMARK(BM_WaveformRead);
@@ -0,0 +1,90 @@
+# Build type, link-time and profile-guided optimization.
+#
+# Release (the default) builds with -O3 and LTO. PGO is a three step cycle:
+#
+#   cmake -DAMM_PGO=GENERATE ..   && make && make pgo-train
+#   cmake -DAMM_PGO=USE ..        && make && cpack -G DEB
+#
+# The profiles are written to AMM_PGO_DIR and survive the reconfigure.
+
+if (NOT CMAKE_BUILD_TYPE AND NOT CMAKE_CONFIGURATION_TYPES)
+    set(CMAKE_BUILD_TYPE Release CACHE STRING "Build type" FORCE)
+    set_property(CACHE CMAKE_BUILD_TYPE PROPERTY STRINGS Debug Release RelWithDebInfo MinSizeRel)
+endif ()
+
+option(AMM_LTO "Link-time optimization for Release builds" ON)
+
+set(AMM_PGO "OFF" CACHE STRING "Profile-guided optimization: OFF, GENERATE or USE")
+set_property(CACHE AMM_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(AMM_PGO_DIR "${CMAKE_BINARY_DIR}/pgo" CACHE PATH "Directory of the PGO profiles")
+
+set(AMM_LTO_ENABLED OFF)
+if (AMM_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT _amm_ipo_supported OUTPUT _amm_ipo_output LANGUAGES CXX)
+    if (_amm_ipo_supported)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELEASE ON)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_RELWITHDEBINFO ON)
+        set(AMM_LTO_ENABLED ON)
+    else ()
+        message(STATUS "LTO not supported by this toolchain: ${_amm_ipo_output}")
+    endif ()
+endif ()
+
+set(AMM_PGO_COMPILE_OPTIONS "")
+set(AMM_PGO_LINK_OPTIONS "")
+if (AMM_PGO STREQUAL "GENERATE")
+    file(MAKE_DIRECTORY ${AMM_PGO_DIR})
+    # Atomic counter updates keep the profile consistent across the server's threads.
+    set(AMM_PGO_COMPILE_OPTIONS -fprofile-generate=${AMM_PGO_DIR} -fprofile-update=atomic)
+    set(AMM_PGO_LINK_OPTIONS -fprofile-generate=${AMM_PGO_DIR})
+elseif (AMM_PGO STREQUAL "USE")
+    if (CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        # Clang reads one merged file; pgo-train produces it with llvm-profdata.
+        set(_amm_profile ${AMM_PGO_DIR}/default.profdata)
+        set(AMM_PGO_COMPILE_OPTIONS -fprofile-use=${_amm_profile} -Wno-profile-instr-unprofiled)
+    else ()
+        set(_amm_profile ${AMM_PGO_DIR})
+        set(AMM_PGO_COMPILE_OPTIONS -fprofile-use=${_amm_profile} -fprofile-correction -Wno-missing-profile)
+    endif ()
+    if (NOT EXISTS ${_amm_profile})
+        message(WARNING "AMM_PGO=USE but no profile at ${_amm_profile}; run the pgo-train target first")
+    endif ()
+    set(AMM_PGO_LINK_OPTIONS -fprofile-use=${_amm_profile})
+elseif (NOT AMM_PGO STREQUAL "OFF")
+    message(FATAL_ERROR "AMM_PGO must be OFF, GENERATE or USE (got '${AMM_PGO}')")
+endif ()
+
+# Applies the PGO flags to a target.
+function(amm_optimize_target target)
+    if (AMM_PGO_COMPILE_OPTIONS)
+        target_compile_options(${target} PRIVATE ${AMM_PGO_COMPILE_OPTIONS})
+        target_link_libraries(${target} PRIVATE ${AMM_PGO_LINK_OPTIONS})
+    endif ()
+endfunction()
+
+# Trains an instrumented build: runs the adapter against scripts/pgo_train.sh, which
+# replays a request mix shaped like a running simulation, then stops it so the profile
+# is flushed.
+function(amm_add_pgo_training target)
+    if (NOT AMM_PGO STREQUAL "GENERATE")
+        return()
+    endif ()
+    set(_amm_env AMM_PGO_DIR=${AMM_PGO_DIR})
+    if (CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        # Clang writes raw profiles that have to be merged before AMM_PGO=USE.
+        find_program(LLVM_PROFDATA NAMES llvm-profdata)
+        if (NOT LLVM_PROFDATA)
+            message(FATAL_ERROR "llvm-profdata is needed to merge Clang PGO profiles")
+        endif ()
+        list(APPEND _amm_env LLVM_PROFDATA=${LLVM_PROFDATA})
+    endif ()
+    add_custom_target(pgo-train
+        COMMAND ${CMAKE_COMMAND} -E env ${_amm_env}
+        ${CMAKE_SOURCE_DIR}/scripts/pgo_train.sh $<TARGET_FILE:${target}>
+        WORKING_DIRECTORY ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}
+        DEPENDS ${target}
+        USES_TERMINAL
+        COMMENT "Training ${target} for profile-guided optimization"
+        )
+endfunction()
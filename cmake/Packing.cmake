@@ -34,4 +34,12 @@ set(CPACK_DEBIAN_FILE_NAME DEB-DEFAULT)
 # list dependencies
 set(CPACK_DEBIAN_PACKAGE_SHLIBDEPS YES)
 
+# packages are meant to ship an optimized binary
+if (NOT CMAKE_CONFIGURATION_TYPES AND NOT CMAKE_BUILD_TYPE MATCHES "^(Release|RelWithDebInfo)$")
+    message(WARNING "Packages built from a ${CMAKE_BUILD_TYPE} build are not optimized")
+endif ()
+if (AMM_PGO STREQUAL "GENERATE")
+    message(WARNING "AMM_PGO=GENERATE builds are instrumented and should not be packaged")
+endif ()
+
 include(CPack)
@@ -0,0 +1,68 @@
+#!/bin/bash
+#
+# Drives an instrumented amm_rest_adapter with a request mix shaped like a running
+# simulation, then stops it with SIGTERM so the profile is written on exit.
+#
+#   pgo_train.sh <path/to/amm_rest_adapter> [seconds]
+#
+# Run it on an isolated machine or DDS domain: the command traffic is really published.
+# LLVM_PROFDATA and AMM_PGO_DIR, when set, merge the raw Clang profiles afterwards.
+
+set -euo pipefail
+# Requests below are split on spaces; keep '?' in URLs literal.
+set -f
+
+ADAPTER=${1:?usage: pgo_train.sh <amm_rest_adapter> [seconds]}
+DURATION=${2:-60}
+URL=${AMM_URL:-http://127.0.0.1:9080}
+
+"$ADAPTER" -nodiscovery -trace_sample 100 &
+PID=$!
+trap 'kill -TERM $PID 2>/dev/null || true' EXIT
+
+for _ in $(seq 1 100); do
+    curl -sf -o /dev/null "$URL/ready" && break
+    sleep 0.1
+done
+
+# Runs one client: repeatedly issues the given requests until the deadline.
+client() {
+    local deadline=$((SECONDS + DURATION))
+    while [ $SECONDS -lt $deadline ]; do
+        for request in "$@"; do
+            curl -s -o /dev/null $request || true
+        done
+    done
+}
+
+COMMAND='{"type":"command","payload":"[ACT]PGO_TRAINING"}'
+RENDER='{"type":"PGO_TRAINING","location":"PGO","payload":"PGO_TRAINING"}'
+# Batch items name their operation with "op"; items without it are rejected.
+BATCH='[{"op":"command","payload":"[ACT]PGO_TRAINING"},{"op":"render_modification","type":"PGO_TRAINING","location":"PGO","payload":"PGO_TRAINING"}]'
+
+# Telemetry dominates real traffic: UIs poll the node table and module list.
+client "$URL/nodes" "$URL/nodes" "$URL/nodes" "$URL/node/Cardiovascular_HeartRate" &
+CLIENTS=($!)
+client "$URL/nodes" "$URL/labs" "$URL/modules" "$URL/instance" &
+CLIENTS+=($!)
+client "$URL/nodes" "$URL/node/Respiratory_Respiration_Rate" "$URL/modules/count" &
+CLIENTS+=($!)
+client "$URL/metrics" "$URL/stats/dds" "$URL/stats/publish" &
+CLIENTS+=($!)
+# Control traffic: commands, modifications and batches, some waiting for the publish.
+client "-X POST -H Content-Type:application/json -d $COMMAND $URL/execute" \
+       "-X POST -H Content-Type:application/json -d $RENDER $URL/topic/render_modification" \
+       "-X POST -H Content-Type:application/json -d $BATCH $URL/batch?wait=1" &
+CLIENTS+=($!)
+# Bulk traffic: listings and exports.
+client "$URL/events" "$URL/logs/csv" "$URL/states" "$URL/scenarios" &
+CLIENTS+=($!)
+wait "${CLIENTS[@]}"
+
+kill -TERM $PID
+wait $PID || true
+trap - EXIT
+
+if [ -n "${LLVM_PROFDATA:-}" ] && [ -n "${AMM_PGO_DIR:-}" ]; then
+    "$LLVM_PROFDATA" merge -output="$AMM_PGO_DIR/default.profdata" "$AMM_PGO_DIR"/*.profraw
+fi
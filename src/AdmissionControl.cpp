@@ -0,0 +1,104 @@
+#include "AdmissionControl.h"
+
+const char *RouteClassName(RouteClass c)
+{
+    switch (c)
+    {
+    case RouteClass::Telemetry:
+        return "telemetry";
+    case RouteClass::Control:
+        return "control";
+    case RouteClass::Bulk:
+        return "bulk";
+    }
+    return "unknown";
+}
+
+AdmissionControl::Ticket::Ticket(Ticket &&other) noexcept : m_slot(other.m_slot)
+{
+    other.m_slot = nullptr;
+}
+
+AdmissionControl::Ticket &AdmissionControl::Ticket::operator=(Ticket &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_slot = other.m_slot;
+        other.m_slot = nullptr;
+    }
+    return *this;
+}
+
+AdmissionControl::Ticket::~Ticket()
+{
+    release();
+}
+
+void AdmissionControl::Ticket::release()
+{
+    if (m_slot != nullptr)
+    {
+        m_slot->fetch_sub(1, std::memory_order_release);
+        m_slot = nullptr;
+    }
+}
+
+void AdmissionControl::setLimit(RouteClass c, int limit)
+{
+    m_classes[static_cast<int>(c)].limit = limit;
+}
+
+int AdmissionControl::limit(RouteClass c) const
+{
+    return m_classes[static_cast<int>(c)].limit;
+}
+
+void AdmissionControl::setRetryAfter(RouteClass c, int seconds)
+{
+    m_classes[static_cast<int>(c)].retryAfter = seconds;
+}
+
+int AdmissionControl::retryAfter(RouteClass c) const
+{
+    return m_classes[static_cast<int>(c)].retryAfter;
+}
+
+AdmissionControl::Ticket AdmissionControl::tryAcquire(RouteClass c)
+{
+    ClassState &state = m_classes[static_cast<int>(c)];
+    if (m_closed.load(std::memory_order_acquire))
+    {
+        state.rejected.fetch_add(1, std::memory_order_relaxed);
+        return Ticket();
+    }
+
+    int current = state.inFlight.fetch_add(1, std::memory_order_acquire);
+    if (state.limit > 0 && current >= state.limit)
+    {
+        state.inFlight.fetch_sub(1, std::memory_order_release);
+        state.rejected.fetch_add(1, std::memory_order_relaxed);
+        return Ticket();
+    }
+    return Ticket(&state.inFlight);
+}
+
+int AdmissionControl::inFlight(RouteClass c) const
+{
+    return m_classes[static_cast<int>(c)].inFlight.load(std::memory_order_relaxed);
+}
+
+int AdmissionControl::inFlight() const
+{
+    int total = 0;
+    for (const auto &state : m_classes)
+    {
+        total += state.inFlight.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t AdmissionControl::rejected(RouteClass c) const
+{
+    return m_classes[static_cast<int>(c)].rejected.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// Priority class of a route; admission limits are tracked per class.
+enum class RouteClass
+{
+    Telemetry, ///< High priority: node and status reads.
+    Control,   ///< High priority: commands and modifications.
+    Bulk,      ///< Low priority: exports, uploads, directory listings.
+};
+
+static constexpr std::size_t RouteClassCount = 3;
+
+const char *RouteClassName(RouteClass c);
+
+/// Bounds the number of requests in flight per route class so that a burst of
+/// low priority work is shed with 503 instead of starving telemetry.
+class AdmissionControl
+{
+public:
+    /// Holds one in-flight slot; releases it on destruction.
+    class Ticket
+    {
+    public:
+        Ticket() = default;
+        Ticket(Ticket &&other) noexcept;
+        Ticket &operator=(Ticket &&other) noexcept;
+        ~Ticket();
+
+        Ticket(const Ticket &) = delete;
+        Ticket &operator=(const Ticket &) = delete;
+
+        explicit operator bool() const { return m_slot != nullptr; }
+
+    private:
+        friend class AdmissionControl;
+        explicit Ticket(std::atomic<int> *slot) : m_slot(slot) {}
+        void release();
+
+        std::atomic<int> *m_slot = nullptr;
+    };
+
+    /// Sets the in-flight limit for a class; 0 or less means unlimited.
+    void setLimit(RouteClass c, int limit);
+    int limit(RouteClass c) const;
+
+    /// Seconds a rejected client should wait before retrying.
+    void setRetryAfter(RouteClass c, int seconds);
+    int retryAfter(RouteClass c) const;
+
+    /// Takes a slot for the class; the returned ticket is empty if the class is full.
+    Ticket tryAcquire(RouteClass c);
+
+    /// Stops admitting new requests of any class (used while draining on shutdown).
+    void close() { m_closed.store(true, std::memory_order_release); }
+
+    int inFlight(RouteClass c) const;
+    int inFlight() const;
+    uint64_t rejected(RouteClass c) const;
+
+private:
+    struct ClassState
+    {
+        std::atomic<int> inFlight{0};
+        std::atomic<uint64_t> rejected{0};
+        int limit = 0;
+        int retryAfter = 1;
+    };
+
+    ClassState m_classes[RouteClassCount];
+    std::atomic<bool> m_closed{false};
+};
@@ -0,0 +1,178 @@
+#include "AsyncLogAppender.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+AsyncLogAppender::AsyncLogAppender(const std::string &path, std::size_t capacity, std::size_t maxBytes,
+                                   int maxFiles)
+    : m_path(path), m_maxBytes(maxBytes), m_maxFiles(maxFiles > 0 ? maxFiles : 1), m_queue(capacity)
+{
+    openFile();
+}
+
+AsyncLogAppender::~AsyncLogAppender()
+{
+    stop();
+    if (m_file != nullptr && m_file != stdout)
+    {
+        std::fclose(m_file);
+    }
+}
+
+void AsyncLogAppender::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+    m_thread = std::thread(&AsyncLogAppender::run, this);
+}
+
+void AsyncLogAppender::stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+    m_thread.join();
+
+    // A write that saw m_running before the exchange may push after the writer's final
+    // drain. Wait for it to finish, then write its line here, under m_fileMutex.
+    while (m_producers.load(std::memory_order_seq_cst) > 0)
+    {
+        std::this_thread::yield();
+    }
+    drain();
+}
+
+void AsyncLogAppender::write(const plog::Record &record)
+{
+    std::string line = plog::TxtFormatter::format(record);
+
+    // Announced before checking m_running, as in PublishQueue::enqueue.
+    m_producers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_running.load(std::memory_order_seq_cst))
+    {
+        m_producers.fetch_sub(1, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        writeLine(line);
+        std::fflush(m_file);
+        return;
+    }
+
+    bool pushed = m_queue.tryPush(std::move(line));
+    m_producers.fetch_sub(1, std::memory_order_release);
+    if (!pushed)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Same handshake as PublishQueue: either the writer sees the line before it sleeps,
+    // or we see it sleeping and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+}
+
+AsyncLogAppender::Stats AsyncLogAppender::stats() const
+{
+    Stats s;
+    s.written = m_written.load(std::memory_order_relaxed);
+    s.dropped = m_dropped.load(std::memory_order_relaxed);
+    s.queued = m_queue.sizeApprox();
+    return s;
+}
+
+void AsyncLogAppender::run()
+{
+    while (m_running.load(std::memory_order_acquire))
+    {
+        if (drain() > 0)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_cond.wait_for(lock, std::chrono::milliseconds(100), [this]
+                        { return !m_queue.emptyApprox() || !m_running.load(std::memory_order_acquire); });
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    while (drain() > 0)
+    {
+    }
+}
+
+std::size_t AsyncLogAppender::drain()
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    std::size_t count = 0;
+    std::string line;
+    while (m_queue.tryPop(line))
+    {
+        writeLine(line);
+        ++count;
+    }
+    // One flush per burst instead of one per line.
+    if (count > 0)
+    {
+        std::fflush(m_file);
+    }
+    return count;
+}
+
+void AsyncLogAppender::writeLine(const std::string &line)
+{
+    if (m_file != stdout && m_fileBytes + line.size() > m_maxBytes)
+    {
+        rotate();
+    }
+    std::fwrite(line.data(), 1, line.size(), m_file);
+    m_fileBytes += line.size();
+    m_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogAppender::openFile()
+{
+    if (m_path.empty())
+    {
+        m_file = stdout;
+        return;
+    }
+    m_file = std::fopen(m_path.c_str(), "a");
+    if (m_file == nullptr)
+    {
+        std::fprintf(stderr, "Unable to open log file %s: %s, logging to stdout\n", m_path.c_str(),
+                     std::strerror(errno));
+        m_file = stdout;
+        return;
+    }
+    std::fseek(m_file, 0, SEEK_END);
+    long size = std::ftell(m_file);
+    m_fileBytes = size > 0 ? static_cast<std::size_t>(size) : 0;
+}
+
+void AsyncLogAppender::rotate()
+{
+    std::fclose(m_file);
+    for (int i = m_maxFiles - 1; i >= 1; --i)
+    {
+        std::string from = m_path + "." + std::to_string(i);
+        std::string to = m_path + "." + std::to_string(i + 1);
+        std::rename(from.c_str(), to.c_str());
+    }
+    std::rename(m_path.c_str(), (m_path + ".1").c_str());
+    m_fileBytes = 0;
+    openFile();
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "amm/BaseLogger.h"
+
+#include "BoundedQueue.h"
+
+/// plog appender that keeps console and disk I/O off the logging thread. Records are
+/// formatted by the caller into a bounded lock-free queue and written by a background
+/// thread, either to stdout or to a size-rotated file. When the queue is full the line is
+/// dropped and counted rather than blocking the caller.
+class AsyncLogAppender : public plog::IAppender
+{
+public:
+    struct Stats
+    {
+        uint64_t written;
+        uint64_t dropped;
+        std::size_t queued;
+    };
+
+    /// An empty path logs to stdout. A file is rotated to path.1 ... path.maxFiles once it
+    /// exceeds maxBytes.
+    explicit AsyncLogAppender(const std::string &path = std::string(), std::size_t capacity = 8192,
+                              std::size_t maxBytes = 10 * 1024 * 1024, int maxFiles = 5);
+    ~AsyncLogAppender();
+
+    AsyncLogAppender(const AsyncLogAppender &) = delete;
+    AsyncLogAppender &operator=(const AsyncLogAppender &) = delete;
+
+    void start();
+
+    /// Writes everything still queued, including lines that raced with the stop, and
+    /// joins the writer thread. Later records are written synchronously.
+    void stop();
+
+    void write(const plog::Record &record) override;
+
+    Stats stats() const;
+
+private:
+    void run();
+    std::size_t drain();
+    void writeLine(const std::string &line);
+    void openFile();
+    void rotate();
+
+    std::string m_path;
+    std::size_t m_maxBytes;
+    int m_maxFiles;
+    FILE *m_file = nullptr;
+    std::size_t m_fileBytes = 0;
+
+    BoundedQueue<std::string> m_queue;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_running{false};
+    /// Writes between their m_running check and the push.
+    std::atomic<int> m_producers{0};
+    std::thread m_thread;
+
+    /// Guards the file between the writer thread and synchronous writes made while the
+    /// writer is not running. Uncontended in steady state.
+    std::mutex m_fileMutex;
+
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
@@ -0,0 +1,121 @@
+#include "AtomicFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Sha256.h"
+
+namespace
+{
+    std::string ErrnoMessage(const char *what, const std::string &path)
+    {
+        return std::string(what) + " " + path + ": " + std::strerror(errno);
+    }
+
+    std::string DirectoryOf(const std::string &path)
+    {
+        std::string::size_type slash = path.rfind('/');
+        if (slash == std::string::npos)
+        {
+            return ".";
+        }
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+
+    bool WriteAll(int fd, const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+}
+
+bool AtomicFile::Write(const std::string &path, const char *data, std::size_t size, Result &result, std::string &error)
+{
+    static std::atomic<unsigned> sequence{0};
+    std::string temp = path + ".part." + std::to_string(::getpid()) + "." + std::to_string(sequence++);
+
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        error = ErrnoMessage("Cannot create", temp);
+        return false;
+    }
+
+    Sha256 hash;
+    std::size_t offset = 0;
+    while (offset < size)
+    {
+        std::size_t chunk = std::min(ChunkSize, size - offset);
+        if (!WriteAll(fd, data + offset, chunk))
+        {
+            error = ErrnoMessage("Cannot write", temp);
+            ::close(fd);
+            ::unlink(temp.c_str());
+            return false;
+        }
+        hash.update(data + offset, chunk);
+        offset += chunk;
+    }
+
+    if (::fsync(fd) != 0)
+    {
+        error = ErrnoMessage("Cannot sync", temp);
+        ::close(fd);
+        ::unlink(temp.c_str());
+        return false;
+    }
+    if (::close(fd) != 0)
+    {
+        error = ErrnoMessage("Cannot close", temp);
+        ::unlink(temp.c_str());
+        return false;
+    }
+    if (::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        error = ErrnoMessage("Cannot rename", temp);
+        ::unlink(temp.c_str());
+        return false;
+    }
+
+    // The rename is only durable once the directory entry itself is on disk.
+    std::string directory = DirectoryOf(path);
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0 || ::fsync(dirFd) != 0)
+    {
+        error = ErrnoMessage("Cannot sync directory", directory);
+        if (dirFd >= 0)
+        {
+            ::close(dirFd);
+        }
+        return false;
+    }
+    ::close(dirFd);
+
+    result.bytes = size;
+    result.sha256 = hash.hexDigest();
+    return true;
+}
+
+bool AtomicFile::IsSafeName(const std::string &name)
+{
+    return !name.empty() && name[0] != '.' && name.find('/') == std::string::npos &&
+           name.find('\0') == std::string::npos;
+}
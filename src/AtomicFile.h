@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// Crash-safe file replacement: data goes to a temp file next to the target in fixed-size
+/// chunks, is fsync'd, and is renamed over the target only once complete, so readers see
+/// either the old file or the whole new one.
+namespace AtomicFile
+{
+    /// Bytes handed to write(2) at a time.
+    static constexpr std::size_t ChunkSize = 64 * 1024;
+
+    struct Result
+    {
+        std::size_t bytes = 0;
+        std::string sha256;
+    };
+
+    /// Writes size bytes to path atomically and durably (file and directory entry are
+    /// synced before returning). On failure the temp file is removed, the existing file is
+    /// left untouched and error is set.
+    bool Write(const std::string &path, const char *data, std::size_t size, Result &result, std::string &error);
+
+    /// True for a plain file name that is safe to join to a storage directory.
+    bool IsSafeName(const std::string &name);
+}
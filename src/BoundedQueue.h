@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/// Fixed-capacity lock-free queue (D. Vyukov's bounded MPMC ring). Pushing to a full
+/// queue fails instead of blocking, which lets producers shed load.
+template <typename T>
+class BoundedQueue
+{
+public:
+    /// Capacity is rounded up to a power of two.
+    explicit BoundedQueue(std::size_t capacity)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    bool tryPush(T &&value)
+    {
+        std::size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = m_cells[pos & m_mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T &value)
+    {
+        std::size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell &cell = m_cells[pos & m_mask];
+            std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.data);
+                    cell.data = T();
+                    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    /// Approximate number of queued items; exact only when quiescent.
+    std::size_t sizeApprox() const
+    {
+        std::size_t tail = m_enqueuePos.load(std::memory_order_relaxed);
+        std::size_t head = m_dequeuePos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    std::size_t m_mask = 0;
+    alignas(64) std::atomic<std::size_t> m_enqueuePos{0};
+    alignas(64) std::atomic<std::size_t> m_dequeuePos{0};
+};
@@ -0,0 +1,54 @@
+#include "CsvExport.h"
+
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+std::string EventLogCsv(sqlite::database &db)
+{
+    std::ostringstream s;
+    db << "SELECT "
+          "module_capabilities.module_name,"
+          "events.source,"
+          "events.topic,"
+          "events.tick,"
+          "events.timestamp,"
+          "events.data "
+          "FROM "
+          "events "
+          "LEFT JOIN module_capabilities "
+          "ON "
+          "events.source = module_capabilities.module_guid" >>
+        [&](std::string module_name, std::string source, std::string topic, int64_t tick, int64_t timestamp,
+            std::string data)
+    {
+        std::time_t temp = timestamp;
+        std::tm *t = std::gmtime(&temp);
+        s << std::put_time(t, "%Y-%m-%d %I:%M:%S %p") << "," << module_name << "," << source << "," << topic
+          << "," << data << std::endl;
+    };
+    return s.str();
+}
+
+std::string DiagnosticLogCsv(sqlite::database &db)
+{
+    std::ostringstream s;
+    db << "SELECT "
+          "logs.module_name, "
+          "logs.module_guid, "
+          "logs.module_id, "
+          "logs.message,"
+          "logs.log_level,"
+          "logs.timestamp "
+          "FROM "
+          "logs " >>
+        [&](std::string module_name, std::string module_guid, std::string module_id, std::string message,
+            std::string log_level, int64_t timestamp)
+    {
+        std::time_t temp = timestamp;
+        std::tm *t = std::gmtime(&temp);
+        s << std::put_time(t, "%Y-%m-%d %I:%M:%S %p") << "," << log_level << "," << module_name << "," << message
+          << std::endl;
+    };
+    return s.str();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+
+#include "thirdparty/sqlite_modern_cpp.h"
+
+/// Timeline export: one line per event with its time, module, source, topic and data.
+std::string EventLogCsv(sqlite::database &db);
+
+/// Diagnostic log export: one line per log entry with its time, level, module and message.
+std::string DiagnosticLogCsv(sqlite::database &db);
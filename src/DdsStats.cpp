@@ -0,0 +1,136 @@
+#include "DdsStats.h"
+
+const uint64_t DdsStats::HandlerBoundsUs[HandlerBucketCount] = {1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 5000, 20000};
+const uint64_t DdsStats::DelayBoundsMs[DelayBucketCount] = {1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 5000, 30000};
+
+namespace
+{
+    template <std::size_t N>
+    std::size_t BucketOf(const uint64_t (&bounds)[N], uint64_t value)
+    {
+        std::size_t i = 0;
+        while (i < N && value > bounds[i])
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    void StoreMax(std::atomic<uint64_t> &max, uint64_t value)
+    {
+        uint64_t current = max.load(std::memory_order_relaxed);
+        while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+const char *DdsTopicName(DdsTopic topic)
+{
+    switch (topic)
+    {
+    case DdsTopic::Status:
+        return "status";
+    case DdsTopic::Tick:
+        return "tick";
+    case DdsTopic::SimulationControl:
+        return "simulation_control";
+    case DdsTopic::Command:
+        return "command";
+    case DdsTopic::PhysiologyValue:
+        return "physiology_value";
+    case DdsTopic::RenderModification:
+        return "render_modification";
+    case DdsTopic::PhysiologyWaveform:
+        return "physiology_waveform";
+    }
+    return "unknown";
+}
+
+DdsStats::Probe::Probe(DdsStats &stats, DdsTopic topic, int64_t sourceNs)
+    : m_stats(stats), m_topic(topic), m_start(std::chrono::steady_clock::now())
+{
+    m_stats.received(topic, sourceNs);
+}
+
+DdsStats::Probe::~Probe()
+{
+    auto elapsed = std::chrono::steady_clock::now() - m_start;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    m_stats.handled(m_topic, static_cast<uint64_t>(ns));
+}
+
+void DdsStats::Probe::dropped()
+{
+    m_stats.m_topics[static_cast<int>(m_topic)].dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DdsStats::received(DdsTopic topic, int64_t sourceNs)
+{
+    TopicCounters &counters = m_topics[static_cast<int>(topic)];
+    counters.received.fetch_add(1, std::memory_order_relaxed);
+    if (sourceNs <= 0)
+    {
+        return;
+    }
+
+    // Source timestamps come from the publisher's wall clock, so compare against ours.
+    int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+    int64_t delayNs = nowNs - sourceNs;
+    if (delayNs < 0)
+    {
+        counters.delayNegative.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t delayUs = static_cast<uint64_t>(delayNs) / 1000;
+    counters.delaySumUs.fetch_add(delayUs, std::memory_order_relaxed);
+    StoreMax(counters.delayMaxUs, delayUs);
+    counters.delayBuckets[BucketOf(DelayBoundsMs, delayUs / 1000)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DdsStats::handled(DdsTopic topic, uint64_t ns)
+{
+    TopicCounters &counters = m_topics[static_cast<int>(topic)];
+    counters.handlerSumNs.fetch_add(ns, std::memory_order_relaxed);
+    StoreMax(counters.handlerMaxNs, ns);
+    counters.handlerBuckets[BucketOf(HandlerBoundsUs, ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DdsStats::snapshot(TopicSnapshot (&topics)[DdsTopicCount])
+{
+    std::lock_guard<std::mutex> lock(m_rateMutex);
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - m_lastSnapshot).count();
+    m_lastSnapshot = now;
+
+    for (std::size_t t = 0; t < DdsTopicCount; ++t)
+    {
+        const TopicCounters &c = m_topics[t];
+        TopicSnapshot &s = topics[t];
+        s.received = c.received.load(std::memory_order_relaxed);
+        s.dropped = c.dropped.load(std::memory_order_relaxed);
+        s.rateHz = seconds > 0 ? (s.received - m_lastReceived[t]) / seconds : 0.0;
+        m_lastReceived[t] = s.received;
+
+        s.handlerCount = 0;
+        for (std::size_t i = 0; i <= HandlerBucketCount; ++i)
+        {
+            s.handlerBuckets[i] = c.handlerBuckets[i].load(std::memory_order_relaxed);
+            s.handlerCount += s.handlerBuckets[i];
+        }
+        s.handlerSumNs = c.handlerSumNs.load(std::memory_order_relaxed);
+        s.handlerMaxNs = c.handlerMaxNs.load(std::memory_order_relaxed);
+
+        s.delayCount = 0;
+        for (std::size_t i = 0; i <= DelayBucketCount; ++i)
+        {
+            s.delayBuckets[i] = c.delayBuckets[i].load(std::memory_order_relaxed);
+            s.delayCount += s.delayBuckets[i];
+        }
+        s.delaySumUs = c.delaySumUs.load(std::memory_order_relaxed);
+        s.delayMaxUs = c.delayMaxUs.load(std::memory_order_relaxed);
+        s.delayNegative = c.delayNegative.load(std::memory_order_relaxed);
+    }
+}
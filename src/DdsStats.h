@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/// DDS topics the REST listener subscribes to.
+enum class DdsTopic
+{
+    Status,
+    Tick,
+    SimulationControl,
+    Command,
+    PhysiologyValue,
+    RenderModification,
+    PhysiologyWaveform,
+};
+
+static constexpr std::size_t DdsTopicCount = 7;
+
+const char *DdsTopicName(DdsTopic topic);
+
+/// Per-topic profile of the DDS listener callbacks: samples received and dropped, time
+/// spent in the handler, and delay between the sample's source timestamp and reception.
+/// Served at /stats/dds to spot a flooding publisher or a handler falling behind.
+class DdsStats
+{
+public:
+    /// Upper bounds of the handler time histogram, in microseconds.
+    static constexpr std::size_t HandlerBucketCount = 12;
+    static const uint64_t HandlerBoundsUs[HandlerBucketCount];
+
+    /// Upper bounds of the delivery delay histogram, in milliseconds.
+    static constexpr std::size_t DelayBucketCount = 12;
+    static const uint64_t DelayBoundsMs[DelayBucketCount];
+
+    /// Measures one callback: counts the sample and its delay on construction and the
+    /// handler time on destruction. sourceNs is the source timestamp since the epoch, or
+    /// 0 when the sample carried no SampleInfo.
+    class Probe
+    {
+    public:
+        Probe(DdsStats &stats, DdsTopic topic, int64_t sourceNs);
+        ~Probe();
+
+        Probe(const Probe &) = delete;
+        Probe &operator=(const Probe &) = delete;
+
+        /// The sample was discarded by the handler (e.g. a NaN value).
+        void dropped();
+
+    private:
+        DdsStats &m_stats;
+        DdsTopic m_topic;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    struct TopicSnapshot
+    {
+        uint64_t received;
+        uint64_t dropped;
+        double rateHz;
+        uint64_t handlerCount;
+        uint64_t handlerSumNs;
+        uint64_t handlerMaxNs;
+        uint64_t handlerBuckets[HandlerBucketCount + 1];
+        uint64_t delayCount;
+        uint64_t delaySumUs;
+        uint64_t delayMaxUs;
+        uint64_t delayNegative;
+        uint64_t delayBuckets[DelayBucketCount + 1];
+    };
+
+    /// Current counters of every topic. The rate is measured since the previous snapshot.
+    void snapshot(TopicSnapshot (&topics)[DdsTopicCount]);
+
+private:
+    struct alignas(64) TopicCounters
+    {
+        std::atomic<uint64_t> received{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> handlerSumNs{0};
+        std::atomic<uint64_t> handlerMaxNs{0};
+        std::atomic<uint64_t> handlerBuckets[HandlerBucketCount + 1] = {};
+        std::atomic<uint64_t> delaySumUs{0};
+        std::atomic<uint64_t> delayMaxUs{0};
+        std::atomic<uint64_t> delayNegative{0};
+        std::atomic<uint64_t> delayBuckets[DelayBucketCount + 1] = {};
+    };
+
+    void received(DdsTopic topic, int64_t sourceNs);
+    void handled(DdsTopic topic, uint64_t ns);
+
+    TopicCounters m_topics[DdsTopicCount];
+
+    std::mutex m_rateMutex;
+    uint64_t m_lastReceived[DdsTopicCount] = {};
+    std::chrono::steady_clock::time_point m_lastSnapshot = std::chrono::steady_clock::now();
+};
@@ -0,0 +1,116 @@
+#include "Deadbands.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "tinyxml2.h"
+
+#include "amm/BaseLogger.h"
+
+namespace
+{
+    /// Reads absolute, relative and min_interval_ms; returns false if none is set.
+    bool ReadBand(const tinyxml2::XMLElement *element, Deadband &band)
+    {
+        band.absolute = std::fabs(element->DoubleAttribute("absolute", 0.0));
+        band.relative = std::fabs(element->DoubleAttribute("relative", 0.0));
+        band.minInterval = std::chrono::milliseconds(std::max(0, element->IntAttribute("min_interval_ms", 0)));
+        return band.absolute > 0.0 || band.relative > 0.0 || band.minInterval.count() > 0;
+    }
+}
+
+bool Deadband::suppresses(double published, double value) const
+{
+    double change = std::fabs(value - published);
+    return change < absolute || change < relative * std::fabs(published);
+}
+
+bool Deadbands::load(const std::string &path)
+{
+    tinyxml2::XMLDocument doc;
+    if (doc.LoadFile(path.c_str()) != tinyxml2::XML_SUCCESS)
+    {
+        return false;
+    }
+
+    const tinyxml2::XMLElement *deadbands = doc.FirstChildElement();
+    if (deadbands != nullptr && std::strcmp(deadbands->Name(), "Deadbands") != 0)
+    {
+        deadbands = deadbands->FirstChildElement("Deadbands");
+    }
+    if (deadbands == nullptr)
+    {
+        return false;
+    }
+
+    Deadband band;
+    if (ReadBand(deadbands, band))
+    {
+        setDefault(band);
+    }
+    for (const tinyxml2::XMLElement *rule = deadbands->FirstChildElement("Deadband"); rule != nullptr;
+         rule = rule->NextSiblingElement("Deadband"))
+    {
+        Deadband ruleBand;
+        ReadBand(rule, ruleBand);
+        if (const char *name = rule->Attribute("name"))
+        {
+            add(name, ruleBand);
+        }
+        else if (const char *prefix = rule->Attribute("prefix"))
+        {
+            addPrefix(prefix, ruleBand);
+        }
+    }
+
+    LOG_INFO << "Deadbands: " << m_names.size() << " node(s), " << m_prefixes.size() << " prefix(es)"
+             << (m_hasDefault ? " and a default" : "");
+    return true;
+}
+
+void Deadbands::setDefault(const Deadband &band)
+{
+    m_default = band;
+    m_hasDefault = true;
+}
+
+void Deadbands::add(const std::string &name, const Deadband &band)
+{
+    m_names[name] = band;
+}
+
+void Deadbands::addPrefix(const std::string &prefix, const Deadband &band)
+{
+    m_prefixes.emplace_back(prefix, band);
+}
+
+bool Deadbands::empty() const
+{
+    return m_names.empty() && m_prefixes.empty() && !m_hasDefault;
+}
+
+const Deadband *Deadbands::find(const std::string &name) const
+{
+    auto it = m_names.find(name);
+    if (it != m_names.end())
+    {
+        return &it->second;
+    }
+
+    const Deadband *best = nullptr;
+    std::size_t bestLength = 0;
+    for (const auto &prefix : m_prefixes)
+    {
+        if (prefix.first.size() >= bestLength && name.compare(0, prefix.first.size(), prefix.first) == 0)
+        {
+            best = &prefix.second;
+            bestLength = prefix.first.size();
+        }
+    }
+    if (best != nullptr)
+    {
+        return best;
+    }
+    return m_hasDefault ? &m_default : nullptr;
+}
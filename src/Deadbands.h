@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// How much a physiology value has to move before the store publishes it.
+struct Deadband
+{
+    /// Changes smaller than this are ignored (0 = off).
+    double absolute = 0.0;
+    /// Changes smaller than this fraction of the published value are ignored (0 = off).
+    double relative = 0.0;
+    /// Updates closer together than this are ignored; the latest value is taken at the
+    /// first sample after the interval.
+    std::chrono::milliseconds minInterval{0};
+
+    /// Whether the change from the published value is too small to publish.
+    bool suppresses(double published, double value) const;
+};
+
+/// Deadbands by node name, by name prefix, and a default for every other node. Read once
+/// at startup from the <Deadbands> element of the ingest configuration:
+///
+///   <Deadbands relative="0.0005">
+///      <Deadband prefix="Cardiovascular_Arterial" absolute="0.5" min_interval_ms="100"/>
+///      <Deadband name="Cardiovascular_HeartRate" absolute="1"/>
+///   </Deadbands>
+///
+/// Attributes on <Deadbands> itself form the default. A name beats a prefix, and the
+/// longest matching prefix wins.
+class Deadbands
+{
+public:
+    /// Returns false, leaving the rules empty, if the file has no <Deadbands> element.
+    bool load(const std::string &path);
+
+    void setDefault(const Deadband &band);
+    void add(const std::string &name, const Deadband &band);
+    void addPrefix(const std::string &prefix, const Deadband &band);
+
+    bool empty() const;
+
+    /// The rule for a node, or nullptr if it has none.
+    const Deadband *find(const std::string &name) const;
+
+private:
+    std::unordered_map<std::string, Deadband> m_names;
+    std::vector<std::pair<std::string, Deadband>> m_prefixes;
+    Deadband m_default;
+    bool m_hasDefault = false;
+};
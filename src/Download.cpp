@@ -0,0 +1,388 @@
+#include "Download.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "amm/BaseLogger.h"
+
+#include "RequestContext.h"
+
+using namespace Pistache;
+
+namespace
+{
+    struct Validators
+    {
+        std::string etag;
+        std::time_t lastModified = 0;
+        bool hasLastModified = false;
+    };
+
+    std::string Header(const Rest::Request &request, const char *name)
+    {
+        auto raw = request.headers().tryGetRaw(name);
+        return raw ? raw->value() : std::string();
+    }
+
+    bool ParseNumber(const std::string &text, std::size_t begin, std::size_t end, uint64_t &value)
+    {
+        if (begin >= end)
+        {
+            return false;
+        }
+        auto result = std::from_chars(text.data() + begin, text.data() + end, value);
+        return result.ec == std::errc() && result.ptr == text.data() + end;
+    }
+
+    /// Weak comparison (RFC 7232 2.3.2): "W/" prefixes are ignored.
+    bool ETagListMatches(const std::string &list, const std::string &etag)
+    {
+        std::size_t pos = 0;
+        while (pos < list.size())
+        {
+            std::size_t comma = list.find(',', pos);
+            std::size_t end = comma == std::string::npos ? list.size() : comma;
+            std::size_t first = list.find_first_not_of(" \t", pos);
+            std::size_t last = list.find_last_not_of(" \t", end - 1);
+            if (first != std::string::npos && first < end && last >= first)
+            {
+                std::string candidate = list.substr(first, last - first + 1);
+                if (candidate == "*")
+                {
+                    return true;
+                }
+                if (candidate.compare(0, 2, "W/") == 0)
+                {
+                    candidate.erase(0, 2);
+                }
+                if (candidate == etag)
+                {
+                    return true;
+                }
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+
+    /// If-None-Match takes precedence; If-Modified-Since is only consulted without it.
+    bool IsNotModified(const Rest::Request &request, const Validators &validators)
+    {
+        std::string ifNoneMatch = Header(request, "If-None-Match");
+        if (!ifNoneMatch.empty())
+        {
+            return ETagListMatches(ifNoneMatch, validators.etag);
+        }
+
+        std::string ifModifiedSince = Header(request, "If-Modified-Since");
+        std::time_t since;
+        if (validators.hasLastModified && !ifModifiedSince.empty() && Download::ParseHttpDate(ifModifiedSince, since))
+        {
+            return validators.lastModified <= since;
+        }
+        return false;
+    }
+
+    /// A resumed download must not splice bytes from two versions: with If-Range the range
+    /// is only honoured if the validator still matches.
+    bool RangeIsCurrent(const Rest::Request &request, const Validators &validators)
+    {
+        std::string ifRange = Header(request, "If-Range");
+        if (ifRange.empty())
+        {
+            return true;
+        }
+        if (ifRange[0] == '"')
+        {
+            return ifRange == validators.etag;
+        }
+        std::time_t date;
+        return validators.hasLastModified && Download::ParseHttpDate(ifRange, date) && validators.lastModified == date;
+    }
+
+    void AddValidators(Http::ResponseWriter &response, const Validators &validators)
+    {
+        response.headers().addRaw(Http::Header::Raw("ETag", validators.etag));
+        if (validators.hasLastModified)
+        {
+            response.headers().addRaw(Http::Header::Raw("Last-Modified", Download::HttpDate(validators.lastModified)));
+        }
+        response.headers().addRaw(Http::Header::Raw("Accept-Ranges", "bytes"));
+    }
+
+    /// Longest range of a file read into memory for a 206. Longer ranges, e.g. resuming a
+    /// large upload, are streamed from disk in StreamChunk pieces.
+    constexpr uint64_t MaxFileSlice = 1024 * 1024;
+    constexpr std::size_t StreamChunk = 256 * 1024;
+
+    /// Shared decision logic: 304, 416, 206 with a slice, or the whole resource. Ranges
+    /// longer than maxSlice are handed to streamRange once Content-Range is set.
+    void Respond(const Rest::Request &request, Http::ResponseWriter &response, const Validators &validators,
+                 uint64_t size, uint64_t maxSlice, const Http::Mime::MediaType &mime,
+                 const std::function<void()> &sendWhole,
+                 const std::function<bool(const Download::ByteRange &, std::string &)> &readRange,
+                 const std::function<void(const Download::ByteRange &)> &streamRange = nullptr)
+    {
+        AddValidators(response, validators);
+
+        if (IsNotModified(request, validators))
+        {
+            SendResponse(response, Http::Code::Not_Modified);
+            return;
+        }
+
+        std::string rangeHeader = Header(request, "Range");
+        Download::ByteRange range;
+        Download::RangeResult result = Download::RangeResult::Whole;
+        if (!rangeHeader.empty() && RangeIsCurrent(request, validators))
+        {
+            result = Download::ParseRange(rangeHeader, size, range);
+        }
+
+        if (result == Download::RangeResult::Unsatisfiable)
+        {
+            response.headers().addRaw(Http::Header::Raw("Content-Range", "bytes */" + std::to_string(size)));
+            SendResponse(response, Http::Code::Range_Not_Satisfiable);
+            return;
+        }
+        if (result == Download::RangeResult::Whole)
+        {
+            sendWhole();
+            return;
+        }
+
+        std::string contentRange = "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" +
+                                   std::to_string(size);
+        if (range.length() > maxSlice && streamRange)
+        {
+            response.headers().addRaw(Http::Header::Raw("Content-Range", contentRange));
+            streamRange(range);
+            return;
+        }
+
+        std::string slice;
+        if (!readRange(range, slice))
+        {
+            SendResponse(response, Http::Code::Internal_Server_Error, "Unable to read file");
+            return;
+        }
+        response.headers().addRaw(Http::Header::Raw("Content-Range", contentRange));
+        SendResponse(response, Http::Code::Partial_Content, slice, mime);
+    }
+
+    bool ReadFileRange(const std::string &path, const Download::ByteRange &range, std::string &slice)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        slice.resize(range.length());
+        std::size_t done = 0;
+        while (done < slice.size())
+        {
+            ssize_t n = ::pread(fd, &slice[done], slice.size() - done, static_cast<off_t>(range.first + done));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                ::close(fd);
+                return false;
+            }
+            done += static_cast<std::size_t>(n);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    /// Sends a 206 for a long range without holding it in memory: the range is read with
+    /// pread one chunk at a time, and each chunk is flushed to the response stream.
+    void StreamFileRange(Http::ResponseWriter &response, const std::string &path, const Download::ByteRange &range,
+                         const Http::Mime::MediaType &mime)
+    {
+        // Uploads are replaced by rename, so once open the file cannot shrink under us;
+        // check here that it still covers the range, while an error can still be sent.
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) <= range.last)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+            SendResponse(response, Http::Code::Internal_Server_Error, "Unable to read file");
+            return;
+        }
+
+        RecordResponse(Http::Code::Partial_Content, static_cast<std::size_t>(range.length()));
+        response.setMime(mime);
+        auto stream = response.stream(Http::Code::Partial_Content);
+        std::vector<char> chunk(StreamChunk);
+        uint64_t offset = range.first;
+        uint64_t remaining = range.length();
+        while (remaining > 0)
+        {
+            std::size_t want = static_cast<std::size_t>(std::min<uint64_t>(chunk.size(), remaining));
+            ssize_t n = ::pread(fd, chunk.data(), want, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                LOG_ERROR << "Range of " << path << " ended early at byte " << offset << ": " << strerror(errno);
+                break;
+            }
+            stream.write(chunk.data(), n);
+            stream.flush();
+            offset += static_cast<uint64_t>(n);
+            remaining -= static_cast<uint64_t>(n);
+        }
+        stream.ends();
+        ::close(fd);
+    }
+}
+
+Download::RangeResult Download::ParseRange(const std::string &header, uint64_t size, ByteRange &range)
+{
+    static const std::string unit = "bytes=";
+    if (header.compare(0, unit.size(), unit) != 0 || header.find(',') != std::string::npos)
+    {
+        return RangeResult::Whole;
+    }
+    std::size_t dash = header.find('-', unit.size());
+    if (dash == std::string::npos)
+    {
+        return RangeResult::Whole;
+    }
+
+    if (dash == unit.size())
+    {
+        // "bytes=-N": the last N bytes.
+        uint64_t suffix;
+        if (!ParseNumber(header, dash + 1, header.size(), suffix))
+        {
+            return RangeResult::Whole;
+        }
+        if (suffix == 0 || size == 0)
+        {
+            return RangeResult::Unsatisfiable;
+        }
+        range.first = suffix < size ? size - suffix : 0;
+        range.last = size - 1;
+        return RangeResult::Partial;
+    }
+
+    uint64_t first;
+    if (!ParseNumber(header, unit.size(), dash, first))
+    {
+        return RangeResult::Whole;
+    }
+    uint64_t last = size == 0 ? 0 : size - 1;
+    if (dash + 1 < header.size())
+    {
+        uint64_t requested;
+        if (!ParseNumber(header, dash + 1, header.size(), requested) || requested < first)
+        {
+            return RangeResult::Whole;
+        }
+        last = std::min(requested, last);
+    }
+    if (first >= size)
+    {
+        return RangeResult::Unsatisfiable;
+    }
+    range.first = first;
+    range.last = last;
+    return RangeResult::Partial;
+}
+
+std::string Download::HttpDate(std::time_t time)
+{
+    std::tm tm;
+    gmtime_r(&time, &tm);
+    char text[32];
+    std::strftime(text, sizeof(text), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return text;
+}
+
+bool Download::ParseHttpDate(const std::string &text, std::time_t &time)
+{
+    std::tm tm = {};
+    const char *end = strptime(text.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (end == nullptr || *end != '\0')
+    {
+        return false;
+    }
+    time = timegm(&tm);
+    return true;
+}
+
+std::string Download::ContentETag(const char *data, std::size_t size)
+{
+    // FNV-1a: cheap, and collisions only cost a spurious 304 between two exports of equal length.
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    char text[48];
+    std::snprintf(text, sizeof(text), "\"%zx-%016llx\"", size, static_cast<unsigned long long>(hash));
+    return text;
+}
+
+void Download::ServeFile(const Rest::Request &request, Http::ResponseWriter &response, const std::string &path)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        SendResponse(response, Http::Code::Not_Found, "File not found");
+        return;
+    }
+
+    // Size and nanosecond mtime change on every rewrite, including our atomic renames.
+    Validators validators;
+    char etag[64];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx%08lx\"", static_cast<unsigned long long>(st.st_size),
+                  static_cast<unsigned long long>(st.st_mtim.tv_sec), static_cast<long>(st.st_mtim.tv_nsec));
+    validators.etag = etag;
+    validators.lastModified = st.st_mtim.tv_sec;
+    validators.hasLastModified = true;
+
+    auto mime = Http::Mime::MediaType::fromFile(path.c_str());
+    Respond(request, response, validators, static_cast<uint64_t>(st.st_size), MaxFileSlice, mime,
+            [&]()
+            {
+                RecordResponse(Http::Code::Ok, static_cast<std::size_t>(st.st_size));
+                Http::serveFile(response, path, mime);
+            },
+            [&](const ByteRange &range, std::string &slice) { return ReadFileRange(path, range, slice); },
+            [&](const ByteRange &range) { StreamFileRange(response, path, range, mime); });
+}
+
+void Download::ServeContent(const Rest::Request &request, Http::ResponseWriter &response, const std::string &content,
+                            const Http::Mime::MediaType &mime)
+{
+    Validators validators;
+    validators.etag = ContentETag(content.data(), content.size());
+
+    Respond(request, response, validators, content.size(), content.size(), mime,
+            [&]() { SendResponse(response, Http::Code::Ok, content, mime); },
+            [&](const ByteRange &range, std::string &slice)
+            {
+                slice.assign(content, range.first, range.length());
+                return true;
+            });
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include <pistache/http.h>
+#include <pistache/router.h>
+
+/// Conditional and partial GET (RFC 7232/7233) for file downloads and generated exports.
+/// Responses carry ETag and, where known, Last-Modified; matching validators get 304, and a
+/// single "bytes=" range gets 206 so interrupted transfers can resume.
+namespace Download
+{
+    struct ByteRange
+    {
+        uint64_t first = 0;
+        uint64_t last = 0;
+
+        uint64_t length() const { return last - first + 1; }
+    };
+
+    enum class RangeResult
+    {
+        Whole,
+        Partial,
+        Unsatisfiable,
+    };
+
+    /// Interprets a Range header for a resource of the given size. Malformed, non-byte and
+    /// multi-range requests are answered with the whole resource, as RFC 7233 allows.
+    RangeResult ParseRange(const std::string &header, uint64_t size, ByteRange &range);
+
+    /// IMF-fixdate, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+    std::string HttpDate(std::time_t time);
+    bool ParseHttpDate(const std::string &text, std::time_t &time);
+
+    /// Strong validator for generated content.
+    std::string ContentETag(const char *data, std::size_t size);
+
+    /// Serves a file on disk, honouring If-None-Match, If-Modified-Since, If-Range and Range.
+    /// The content type is guessed from the extension; unknown files get 404. Ranges over
+    /// 1 MiB are streamed from disk in chunks rather than buffered.
+    void ServeFile(const Pistache::Rest::Request &request, Pistache::Http::ResponseWriter &response,
+                   const std::string &path);
+
+    /// Serves an in-memory body (e.g. a CSV export) the same way, with a content-hash ETag.
+    void ServeContent(const Pistache::Rest::Request &request, Pistache::Http::ResponseWriter &response,
+                      const std::string &content, const Pistache::Http::Mime::MediaType &mime);
+}
@@ -0,0 +1,243 @@
+#include "HttpMetrics.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    const int StatusCodes[] = {0, 200, 201, 204, 206, 304, 400, 403, 404, 413, 416, 500, 503};
+    static constexpr std::size_t KnownStatusCount = sizeof(StatusCodes) / sizeof(StatusCodes[0]);
+
+    const uint64_t LatencyBoundsNs[] = {100000,     250000,     500000,     1000000,    2500000,   5000000,
+                                        10000000,   25000000,   50000000,   100000000,  250000000, 500000000,
+                                        1000000000, 2500000000, 5000000000, 10000000000};
+
+    const uint64_t SizeBounds[] = {64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216, 67108864};
+
+    template <std::size_t N>
+    std::size_t BucketOf(const uint64_t (&bounds)[N], uint64_t value)
+    {
+        std::size_t i = 0;
+        while (i < N && value > bounds[i])
+        {
+            ++i;
+        }
+        return i;
+    }
+
+    /// Single-writer increment: a plain load and store, no locked read-modify-write.
+    inline void Bump(std::atomic<uint64_t> &counter, uint64_t by = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+    void AppendLine(std::string &out, const char *format, ...)
+    {
+        char line[512];
+        va_list args;
+        va_start(args, format);
+        int n = std::vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (n > 0)
+        {
+            out.append(line, std::min<std::size_t>(static_cast<std::size_t>(n), sizeof(line) - 1));
+        }
+    }
+}
+
+struct HttpMetrics::Totals
+{
+    uint64_t started = 0;
+    uint64_t completed = 0;
+    uint64_t status[StatusSlots] = {};
+    uint64_t latency[LatencyBucketCount + 1] = {};
+    uint64_t latencySumNs = 0;
+    uint64_t size[SizeBucketCount + 1] = {};
+    uint64_t bytes = 0;
+};
+
+int HttpMetrics::addRoute(const std::string &method, const std::string &path)
+{
+    if (m_routes.size() >= MaxRoutes)
+    {
+        throw std::length_error("Too many metered routes");
+    }
+    m_routes.push_back({method, path});
+    return static_cast<int>(m_routes.size() - 1);
+}
+
+std::string HttpMetrics::routeName(int route) const
+{
+    if (route < 0 || static_cast<std::size_t>(route) >= m_routes.size())
+    {
+        return "unknown";
+    }
+    return m_routes[route].method + " " + m_routes[route].path;
+}
+
+HttpMetrics::Shard &HttpMetrics::localShard()
+{
+    thread_local const HttpMetrics *owner = nullptr;
+    thread_local Shard *shard = nullptr;
+    if (owner != this)
+    {
+        std::lock_guard<std::mutex> lock(m_shardsMutex);
+        m_shards.emplace_back(new Shard());
+        shard = m_shards.back().get();
+        owner = this;
+    }
+    return *shard;
+}
+
+void HttpMetrics::recordStart(int route)
+{
+    Bump(localShard().routes[route].started);
+}
+
+void HttpMetrics::recordResponse(int route, int status, std::size_t bytes, uint64_t latencyNs)
+{
+    RouteCounters &counters = localShard().routes[route];
+    Bump(counters.completed);
+
+    std::size_t slot = KnownStatusCount;
+    for (std::size_t i = 0; i < KnownStatusCount; ++i)
+    {
+        if (StatusCodes[i] == status)
+        {
+            slot = i;
+            break;
+        }
+    }
+    Bump(counters.status[slot]);
+
+    Bump(counters.latency[BucketOf(LatencyBoundsNs, latencyNs)]);
+    Bump(counters.latencySumNs, latencyNs);
+    Bump(counters.size[BucketOf(SizeBounds, bytes)]);
+    Bump(counters.bytes, bytes);
+}
+
+void HttpMetrics::sum(int route, Totals &totals) const
+{
+    std::lock_guard<std::mutex> lock(m_shardsMutex);
+    for (const auto &shard : m_shards)
+    {
+        const RouteCounters &c = shard->routes[route];
+        totals.started += c.started.load(std::memory_order_relaxed);
+        totals.completed += c.completed.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < StatusSlots; ++i)
+        {
+            totals.status[i] += c.status[i].load(std::memory_order_relaxed);
+        }
+        for (std::size_t i = 0; i <= LatencyBucketCount; ++i)
+        {
+            totals.latency[i] += c.latency[i].load(std::memory_order_relaxed);
+        }
+        totals.latencySumNs += c.latencySumNs.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i <= SizeBucketCount; ++i)
+        {
+            totals.size[i] += c.size[i].load(std::memory_order_relaxed);
+        }
+        totals.bytes += c.bytes.load(std::memory_order_relaxed);
+    }
+}
+
+void HttpMetrics::render(std::string &out) const
+{
+    std::vector<Totals> totals(m_routes.size());
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        sum(static_cast<int>(r), totals[r]);
+    }
+
+    out += "# HELP amm_http_requests_total Requests received, by route.\n"
+           "# TYPE amm_http_requests_total counter\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        AppendLine(out, "amm_http_requests_total{method=\"%s\",route=\"%s\"} %llu\n", m_routes[r].method.c_str(),
+                   m_routes[r].path.c_str(), static_cast<unsigned long long>(totals[r].started));
+    }
+
+    out += "# HELP amm_http_requests_in_flight Requests received but not yet answered.\n"
+           "# TYPE amm_http_requests_in_flight gauge\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        // Shards are summed without a snapshot, so a response can be seen before its start.
+        long long inFlight = static_cast<long long>(totals[r].started - totals[r].completed);
+        AppendLine(out, "amm_http_requests_in_flight{method=\"%s\",route=\"%s\"} %lld\n",
+                   m_routes[r].method.c_str(), m_routes[r].path.c_str(), inFlight > 0 ? inFlight : 0);
+    }
+
+    out += "# HELP amm_http_responses_total Responses sent, by status code (0 = never answered).\n"
+           "# TYPE amm_http_responses_total counter\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        for (std::size_t i = 0; i < StatusSlots; ++i)
+        {
+            if (totals[r].status[i] == 0)
+            {
+                continue;
+            }
+            std::string code = i < KnownStatusCount ? std::to_string(StatusCodes[i]) : "other";
+            AppendLine(out, "amm_http_responses_total{method=\"%s\",route=\"%s\",code=\"%s\"} %llu\n",
+                       m_routes[r].method.c_str(), m_routes[r].path.c_str(), code.c_str(),
+                       static_cast<unsigned long long>(totals[r].status[i]));
+        }
+    }
+
+    out += "# HELP amm_http_request_duration_seconds Time from routing to the response being handed to the "
+           "transport.\n"
+           "# TYPE amm_http_request_duration_seconds histogram\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        const char *method = m_routes[r].method.c_str();
+        const char *path = m_routes[r].path.c_str();
+        uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < LatencyBucketCount; ++i)
+        {
+            cumulative += totals[r].latency[i];
+            AppendLine(out, "amm_http_request_duration_seconds_bucket{method=\"%s\",route=\"%s\",le=\"%g\"} %llu\n",
+                       method, path, LatencyBoundsNs[i] / 1e9, static_cast<unsigned long long>(cumulative));
+        }
+        cumulative += totals[r].latency[LatencyBucketCount];
+        AppendLine(out, "amm_http_request_duration_seconds_bucket{method=\"%s\",route=\"%s\",le=\"+Inf\"} %llu\n",
+                   method, path, static_cast<unsigned long long>(cumulative));
+        AppendLine(out, "amm_http_request_duration_seconds_sum{method=\"%s\",route=\"%s\"} %.9f\n", method, path,
+                   totals[r].latencySumNs / 1e9);
+        AppendLine(out, "amm_http_request_duration_seconds_count{method=\"%s\",route=\"%s\"} %llu\n", method, path,
+                   static_cast<unsigned long long>(cumulative));
+    }
+
+    out += "# HELP amm_http_response_size_bytes Response body sizes.\n"
+           "# TYPE amm_http_response_size_bytes histogram\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        const char *method = m_routes[r].method.c_str();
+        const char *path = m_routes[r].path.c_str();
+        uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < SizeBucketCount; ++i)
+        {
+            cumulative += totals[r].size[i];
+            AppendLine(out, "amm_http_response_size_bytes_bucket{method=\"%s\",route=\"%s\",le=\"%llu\"} %llu\n",
+                       method, path, static_cast<unsigned long long>(SizeBounds[i]),
+                       static_cast<unsigned long long>(cumulative));
+        }
+        cumulative += totals[r].size[SizeBucketCount];
+        AppendLine(out, "amm_http_response_size_bytes_bucket{method=\"%s\",route=\"%s\",le=\"+Inf\"} %llu\n", method,
+                   path, static_cast<unsigned long long>(cumulative));
+        AppendLine(out, "amm_http_response_size_bytes_sum{method=\"%s\",route=\"%s\"} %llu\n", method, path,
+                   static_cast<unsigned long long>(totals[r].bytes));
+        AppendLine(out, "amm_http_response_size_bytes_count{method=\"%s\",route=\"%s\"} %llu\n", method, path,
+                   static_cast<unsigned long long>(cumulative));
+    }
+
+    out += "# HELP amm_http_response_bytes_total Response body bytes sent.\n"
+           "# TYPE amm_http_response_bytes_total counter\n";
+    for (std::size_t r = 0; r < m_routes.size(); ++r)
+    {
+        AppendLine(out, "amm_http_response_bytes_total{method=\"%s\",route=\"%s\"} %llu\n",
+                   m_routes[r].method.c_str(), m_routes[r].path.c_str(),
+                   static_cast<unsigned long long>(totals[r].bytes));
+    }
+}
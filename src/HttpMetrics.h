@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Per-route HTTP counters, rendered in the Prometheus text format at /metrics.
+/// Every thread records into its own cache-line-aligned shard with relaxed stores, so
+/// instrumenting the hot path adds no shared writes; a scrape sums all shards.
+class HttpMetrics
+{
+public:
+    static constexpr std::size_t MaxRoutes = 64;
+
+    /// Registers a route and returns its id. Routes must be added before serving starts.
+    int addRoute(const std::string &method, const std::string &path);
+
+    /// "METHOD /path" of a registered route.
+    std::string routeName(int route) const;
+
+    void recordStart(int route);
+    void recordResponse(int route, int status, std::size_t bytes, uint64_t latencyNs);
+
+    /// Appends all counters in the Prometheus text exposition format.
+    void render(std::string &out) const;
+
+private:
+    static constexpr std::size_t StatusSlots = 14;
+    static constexpr std::size_t LatencyBucketCount = 16;
+    static constexpr std::size_t SizeBucketCount = 11;
+
+    /// Counters of one route on one thread. Only the owning thread writes them.
+    struct alignas(64) RouteCounters
+    {
+        std::atomic<uint64_t> started{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> status[StatusSlots] = {};
+        std::atomic<uint64_t> latency[LatencyBucketCount + 1] = {};
+        std::atomic<uint64_t> latencySumNs{0};
+        std::atomic<uint64_t> size[SizeBucketCount + 1] = {};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    struct Shard
+    {
+        RouteCounters routes[MaxRoutes];
+    };
+
+    struct Route
+    {
+        std::string method;
+        std::string path;
+    };
+
+    struct Totals;
+
+    Shard &localShard();
+    void sum(int route, Totals &totals) const;
+
+    std::vector<Route> m_routes;
+    mutable std::mutex m_shardsMutex;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
@@ -0,0 +1,213 @@
+#include "IngestFilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "tinyxml2.h"
+
+#include "amm/BaseLogger.h"
+
+const std::vector<std::string> IngestFilter::LabPrefixes = {"BloodChemistry_", "CompleteBloodCount_",
+                                                            "MetabolicPanel_", "Substance_"};
+
+namespace
+{
+    int64_t SteadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    bool ParseMode(const char *text, IngestMode &mode)
+    {
+        if (text == nullptr || std::strcmp(text, "all") == 0)
+        {
+            mode = IngestMode::All;
+        }
+        else if (std::strcmp(text, "list") == 0)
+        {
+            mode = IngestMode::List;
+        }
+        else if (std::strcmp(text, "learn") == 0)
+        {
+            mode = IngestMode::Learn;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+}
+
+const char *IngestModeName(IngestMode mode)
+{
+    switch (mode)
+    {
+    case IngestMode::All:
+        return "all";
+    case IngestMode::List:
+        return "list";
+    case IngestMode::Learn:
+        return "learn";
+    }
+    return "unknown";
+}
+
+bool IngestFilter::Rules::matches(const std::string &name) const
+{
+    if (names.find(name) != names.end())
+    {
+        return true;
+    }
+    for (const std::string &prefix : prefixes)
+    {
+        if (name.compare(0, prefix.size(), prefix) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+IngestFilter::IngestFilter() : m_rules(std::make_shared<Rules>())
+{
+}
+
+bool IngestFilter::load(const std::string &path)
+{
+    tinyxml2::XMLDocument doc;
+    tinyxml2::XMLError result = doc.LoadFile(path.c_str());
+    if (result == tinyxml2::XML_ERROR_FILE_NOT_FOUND)
+    {
+        LOG_INFO << "No ingest configuration at " << path << ", ingesting every node";
+        return false;
+    }
+    if (result != tinyxml2::XML_SUCCESS)
+    {
+        LOG_ERROR << "Unable to read ingest configuration " << path << ": " << doc.ErrorStr();
+        return false;
+    }
+
+    const tinyxml2::XMLElement *ingest = doc.FirstChildElement();
+    if (ingest != nullptr && std::strcmp(ingest->Name(), "Ingest") != 0)
+    {
+        ingest = ingest->FirstChildElement("Ingest");
+    }
+    if (ingest == nullptr)
+    {
+        LOG_INFO << "No <Ingest> element in " << path << ", ingesting every node";
+        return false;
+    }
+
+    IngestMode mode;
+    if (!ParseMode(ingest->Attribute("mode"), mode))
+    {
+        LOG_ERROR << "Ingest mode must be all, list or learn (got " << ingest->Attribute("mode") << ")";
+        return false;
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::string> prefixes;
+    for (const tinyxml2::XMLElement *node = ingest->FirstChildElement("Node"); node != nullptr;
+         node = node->NextSiblingElement("Node"))
+    {
+        if (const char *name = node->Attribute("name"))
+        {
+            names.emplace_back(name);
+        }
+        else if (const char *prefix = node->Attribute("prefix"))
+        {
+            prefixes.emplace_back(prefix);
+        }
+    }
+
+    configure(mode, names, prefixes, ingest->IntAttribute("lease", 60));
+    LOG_INFO << "Ingest mode " << IngestModeName(mode) << ": " << names.size() << " node(s), " << prefixes.size()
+             << " prefix(es)";
+    return true;
+}
+
+void IngestFilter::configure(IngestMode mode, const std::vector<std::string> &names,
+                             const std::vector<std::string> &prefixes, int leaseSeconds)
+{
+    std::shared_ptr<Rules> rules = std::make_shared<Rules>();
+    rules->names.insert(names.begin(), names.end());
+    rules->prefixes = prefixes;
+    rules->prefixes.insert(rules->prefixes.end(), LabPrefixes.begin(), LabPrefixes.end());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_learned = 0;
+    m_leaseNs.store(static_cast<int64_t>(std::max(0, leaseSeconds)) * 1000000000, std::memory_order_relaxed);
+    m_openUntilNs.store(0, std::memory_order_relaxed);
+    std::atomic_store(&m_rules, std::shared_ptr<const Rules>(std::move(rules)));
+    m_mode.store(mode, std::memory_order_release);
+}
+
+bool IngestFilter::accepts(const std::string &name) const
+{
+    IngestMode mode = m_mode.load(std::memory_order_acquire);
+    if (mode == IngestMode::All)
+    {
+        return true;
+    }
+    if (std::atomic_load(&m_rules)->matches(name))
+    {
+        return true;
+    }
+    return mode == IngestMode::Learn && leaseOpen();
+}
+
+void IngestFilter::requested(const std::string &name)
+{
+    if (m_mode.load(std::memory_order_acquire) != IngestMode::Learn || std::atomic_load(&m_rules)->matches(name))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<const Rules> current = std::atomic_load(&m_rules);
+    if (current->matches(name))
+    {
+        return;
+    }
+    if (m_learned >= MaxLearnedNames)
+    {
+        LOG_WARNING << "Ingest allow-list is full, not learning " << name;
+        return;
+    }
+    std::shared_ptr<Rules> next = std::make_shared<Rules>(*current);
+    next->names.insert(name);
+    ++m_learned;
+    std::atomic_store(&m_rules, std::shared_ptr<const Rules>(std::move(next)));
+    LOG_INFO << "Ingesting " << name << " on request";
+}
+
+void IngestFilter::requestedAll()
+{
+    if (m_mode.load(std::memory_order_acquire) != IngestMode::Learn)
+    {
+        return;
+    }
+    m_openUntilNs.store(SteadyNowNs() + m_leaseNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+IngestMode IngestFilter::mode() const
+{
+    return m_mode.load(std::memory_order_acquire);
+}
+
+bool IngestFilter::leaseOpen() const
+{
+    return m_openUntilNs.load(std::memory_order_relaxed) > SteadyNowNs();
+}
+
+void IngestFilter::allowed(std::vector<std::string> &names, std::vector<std::string> &prefixes) const
+{
+    std::shared_ptr<const Rules> rules = std::atomic_load(&m_rules);
+    names.assign(rules->names.begin(), rules->names.end());
+    std::sort(names.begin(), names.end());
+    prefixes = rules->prefixes;
+}
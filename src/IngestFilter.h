@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/// Which physiology nodes the listener ingests.
+enum class IngestMode
+{
+    /// Every PhysiologyValue (the default).
+    All,
+    /// Only the configured names and prefixes.
+    List,
+    /// The configured ones plus whatever clients ask for at /node/<name>. A request for
+    /// /nodes opens ingestion to every node for a lease, renewed by each request.
+    Learn,
+};
+
+/// Allow-list of physiology node names, checked before a value is stored. The engine
+/// publishes hundreds of nodes that no client reads; rejecting them early saves the store,
+/// the stats and the /nodes serialization from carrying them.
+///
+/// Fast-RTPS 1.x has no ContentFilteredTopic, so samples are still received and
+/// deserialized; the filter only stops them at the top of onNewPhysiologyValue.
+class IngestFilter
+{
+public:
+    /// Node families the lab report reads; always ingested so that labs stay complete.
+    static const std::vector<std::string> LabPrefixes;
+
+    /// Learned names are capped so that requests for made-up nodes cannot grow the set
+    /// without bound.
+    static constexpr std::size_t MaxLearnedNames = 4096;
+
+    IngestFilter();
+
+    /// Reads the <Ingest> element of an XML file:
+    ///
+    ///   <Ingest mode="learn" lease="60">
+    ///      <Node name="Cardiovascular_HeartRate"/>
+    ///      <Node prefix="Respiratory_"/>
+    ///   </Ingest>
+    ///
+    /// Returns false, leaving the filter unchanged, if the file is missing or malformed.
+    bool load(const std::string &path);
+
+    void configure(IngestMode mode, const std::vector<std::string> &names, const std::vector<std::string> &prefixes,
+                   int leaseSeconds = 60);
+
+    /// Whether a sample of this node should be stored. Called for every PhysiologyValue.
+    bool accepts(const std::string &name) const;
+
+    /// A client asked for this node. In learn mode it is ingested from the next sample on.
+    void requested(const std::string &name);
+
+    /// A client asked for every node. In learn mode all nodes are ingested for the lease.
+    void requestedAll();
+
+    IngestMode mode() const;
+
+    /// Whether a /nodes lease currently admits every node.
+    bool leaseOpen() const;
+
+    void allowed(std::vector<std::string> &names, std::vector<std::string> &prefixes) const;
+
+private:
+    struct Rules
+    {
+        std::unordered_set<std::string> names;
+        std::vector<std::string> prefixes;
+
+        bool matches(const std::string &name) const;
+    };
+
+    std::atomic<IngestMode> m_mode{IngestMode::All};
+    std::atomic<int64_t> m_leaseNs{60000000000};
+    std::atomic<int64_t> m_openUntilNs{0};
+
+    /// Replaced copy-on-write under m_mutex; read without locking.
+    std::shared_ptr<const Rules> m_rules;
+    std::size_t m_learned = 0;
+    std::mutex m_mutex;
+};
+
+const char *IngestModeName(IngestMode mode);
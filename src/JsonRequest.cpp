@@ -0,0 +1,254 @@
+#include "JsonRequest.h"
+
+#include <memory>
+#include <vector>
+
+#include "rapidjson/error/en.h"
+#include "rapidjson/schema.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+using namespace rapidjson;
+
+namespace
+{
+    typedef GenericDocument<UTF8<>, MemoryPoolAllocator<>, MemoryPoolAllocator<>> ArenaDocument;
+
+    static constexpr int KindCount = static_cast<int>(RequestKind::Batch) + 1;
+
+    const char *const CommandSchema = R"({
+        "type": "object",
+        "required": ["payload"],
+        "properties": {
+            "payload": {"type": "string", "minLength": 1}
+        }
+    })";
+
+    const char *const ModificationSchema = R"({
+        "type": "object",
+        "properties": {
+            "type": {"type": "string"},
+            "location": {"type": "string"},
+            "practitioner": {"type": "string"},
+            "payload": {"type": "string"}
+        }
+    })";
+
+    const char *const AssessmentSchema = R"({
+        "type": "object",
+        "properties": {
+            "type": {"type": "string"},
+            "location": {"type": "string"},
+            "practitioner": {"type": "string"},
+            "info": {"type": "string"},
+            "step": {"type": "string"},
+            "comment": {"type": "string"}
+        }
+    })";
+
+    // Items are checked one by one against their op's schema, so that a bad item only
+    // fails itself rather than the whole batch.
+    const char *const BatchSchema = R"({
+        "type": "array",
+        "maxItems": 256
+    })";
+
+    std::unique_ptr<SchemaDocument> schemas[KindCount];
+
+    /// Validator whose per-validation state (schema stack, property flags, hashers) comes
+    /// from the arena's pool instead of the CRT heap.
+    typedef GenericSchemaValidator<SchemaDocument, BaseReaderHandler<UTF8<>, void>, MemoryPoolAllocator<>>
+        PooledValidator;
+
+    /// Per-thread parse state. The document, parser stack and validator state live in
+    /// fixed buffers that are rewound before each use. The pool allocators put their own
+    /// headers inside the buffer, so each buffer has HeaderRoom bytes on top of the
+    /// capacity handed out from it. Only unusually large or deeply nested bodies spill
+    /// into heap chunks, which the next rewind releases.
+    struct ParseArena
+    {
+        static constexpr size_t HeaderRoom = 256;
+        static constexpr size_t ValueCapacity = 16 * 1024;
+        static constexpr size_t StackCapacity = 4 * 1024;
+        static constexpr size_t StateCapacity = 8 * 1024;
+
+        std::vector<char> body;
+        char valueBuffer[ValueCapacity + HeaderRoom];
+        char stackBuffer[StackCapacity + HeaderRoom];
+        char stateBuffer[StateCapacity + HeaderRoom];
+        MemoryPoolAllocator<> valueAllocator;
+        MemoryPoolAllocator<> stackAllocator;
+        MemoryPoolAllocator<> stateAllocator;
+        ArenaDocument document;
+
+        ParseArena()
+            : valueAllocator(valueBuffer, sizeof(valueBuffer)),
+              stackAllocator(stackBuffer, sizeof(stackBuffer)),
+              stateAllocator(stateBuffer, sizeof(stateBuffer)),
+              document(&valueAllocator, StackCapacity, &stackAllocator)
+        {
+        }
+    };
+
+    ParseArena &Arena()
+    {
+        thread_local ParseArena arena;
+        return arena;
+    }
+
+    std::string_view View(const Value &object, const char *name)
+    {
+        auto it = object.FindMember(name);
+        if (it == object.MemberEnd() || !it->value.IsString())
+        {
+            return {};
+        }
+        return std::string_view(it->value.GetString(), it->value.GetStringLength());
+    }
+
+    bool Validate(const Value &value, RequestKind kind, std::string &error)
+    {
+        // The validator's stacks live in the pool, so it is built per call and destroyed
+        // before the pool is rewound; construction itself allocates nothing.
+        ParseArena &arena = Arena();
+        arena.stateAllocator.Clear();
+        PooledValidator validator(*schemas[static_cast<int>(kind)], &arena.stateAllocator);
+        if (!value.Accept(validator))
+        {
+            error = std::string("Request does not match schema (") + validator.GetInvalidSchemaKeyword() + ")";
+            return false;
+        }
+        return true;
+    }
+
+    bool KindFromOp(std::string_view op, RequestKind &kind)
+    {
+        if (op == "command")
+        {
+            kind = RequestKind::Command;
+        }
+        else if (op == "physiology_modification")
+        {
+            kind = RequestKind::PhysiologyModification;
+        }
+        else if (op == "render_modification")
+        {
+            kind = RequestKind::RenderModification;
+        }
+        else if (op == "performance_assessment")
+        {
+            kind = RequestKind::PerformanceAssessment;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    void ExtractFields(const Value &value, RequestKind kind, OperationFields &fields)
+    {
+        fields = OperationFields();
+        fields.kind = kind;
+        fields.type = View(value, "type");
+        fields.location = View(value, "location");
+        fields.practitioner = View(value, "practitioner");
+        fields.payload = View(value, "payload");
+        if (kind == RequestKind::PerformanceAssessment)
+        {
+            fields.info = View(value, "info");
+            fields.step = View(value, "step");
+            fields.comment = View(value, "comment");
+        }
+    }
+}
+
+namespace JsonRequest
+{
+    void CompileSchemas()
+    {
+        const char *sources[KindCount] = {CommandSchema, ModificationSchema, ModificationSchema,
+                                          AssessmentSchema, BatchSchema};
+        for (int i = 0; i < KindCount; ++i)
+        {
+            Document schema;
+            schema.Parse(sources[i]);
+            schemas[i].reset(new SchemaDocument(schema));
+        }
+    }
+
+    const Value *Parse(const std::string &body, RequestKind kind, std::string &error)
+    {
+        ParseArena &arena = Arena();
+
+        // In-situ parsing needs a writable, NUL-terminated copy; the vector keeps its capacity.
+        arena.body.assign(body.begin(), body.end());
+        arena.body.push_back('\0');
+
+        // Every parse, failed ones included, ends by releasing the parser stack, and the
+        // pool's Free is a no-op. Both pools are rewound here so the next stack comes from
+        // the fixed buffer again instead of a fresh heap chunk.
+        arena.valueAllocator.Clear();
+        arena.stackAllocator.Clear();
+        arena.document.ParseInsitu(arena.body.data());
+        if (arena.document.HasParseError())
+        {
+            error = std::string("Malformed JSON at offset ") + std::to_string(arena.document.GetErrorOffset()) +
+                    ": " + GetParseError_En(arena.document.GetParseError());
+            return nullptr;
+        }
+
+        if (!Validate(arena.document, kind, error))
+        {
+            return nullptr;
+        }
+        return &arena.document;
+    }
+
+    bool Extract(const Value &value, RequestKind kind, OperationFields &fields, std::string &error)
+    {
+        if (kind == RequestKind::Batch)
+        {
+            if (!value.IsObject())
+            {
+                error = "operation must be an object";
+                return false;
+            }
+            std::string_view op = View(value, "op");
+            if (!KindFromOp(op, kind))
+            {
+                error = "unknown op '" + std::string(op) + "'";
+                return false;
+            }
+        }
+
+        if (!Validate(value, kind, error))
+        {
+            return false;
+        }
+        ExtractFields(value, kind, fields);
+        return true;
+    }
+
+    bool ParseOperation(const std::string &body, RequestKind kind, OperationFields &fields, std::string &error)
+    {
+        const Value *root = Parse(body, kind, error);
+        if (root == nullptr)
+        {
+            return false;
+        }
+        ExtractFields(*root, kind, fields);
+        return true;
+    }
+
+    std::string ErrorBody(const std::string &error)
+    {
+        StringBuffer s;
+        Writer<StringBuffer> writer(s);
+        writer.StartObject();
+        writer.Key("message");
+        writer.String(error.c_str(), static_cast<SizeType>(error.size()));
+        writer.EndObject();
+        return std::string(s.GetString(), s.GetSize());
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "rapidjson/document.h"
+
+/// Shape of a JSON request body; each kind has a schema compiled once at startup.
+enum class RequestKind
+{
+    Command,
+    PhysiologyModification,
+    RenderModification,
+    PerformanceAssessment,
+    Batch,
+};
+
+/// Fields of a command or modification. The views point into the calling thread's parse
+/// arena and stay valid until that thread parses the next request.
+struct OperationFields
+{
+    RequestKind kind = RequestKind::Command;
+    std::string_view type;
+    std::string_view location;
+    std::string_view practitioner;
+    std::string_view payload;
+    std::string_view info;
+    std::string_view step;
+    std::string_view comment;
+};
+
+namespace JsonRequest
+{
+    /// Compiles the request schemas. Must be called once before the first parse.
+    void CompileSchemas();
+
+    /// Parses a body in-situ into the calling thread's arena and validates it against the
+    /// schema of the given kind. Returns the root value, or nullptr with error set.
+    /// Memory is reused between calls; a warmed-up thread only touches the heap for bodies
+    /// that outgrow its arena buffers.
+    const rapidjson::Value *Parse(const std::string &body, RequestKind kind, std::string &error);
+
+    /// Validates one operation object and extracts its fields. For RequestKind::Batch the
+    /// kind is taken from the object's "op" member.
+    bool Extract(const rapidjson::Value &value, RequestKind kind, OperationFields &fields, std::string &error);
+
+    /// Convenience for single-operation routes: Parse followed by Extract.
+    bool ParseOperation(const std::string &body, RequestKind kind, OperationFields &fields, std::string &error);
+
+    /// {"message": error} with proper escaping, for 400 responses.
+    std::string ErrorBody(const std::string &error);
+}
@@ -0,0 +1,387 @@
+#include "NodeData.h"
+
+#include <sstream>
+
+#include <boost/algorithm/string/join.hpp>
+
+double NodeStore::Snapshot::value(const std::string &name) const
+{
+    auto it = values.find(name);
+    return it != values.end() ? it->second : 0.0;
+}
+
+NodeStore::NodeStore()
+    : m_lastCommit(std::chrono::steady_clock::now()), m_front(std::make_shared<Snapshot>())
+{
+}
+
+void NodeStore::setDeadbands(const Deadbands &deadbands)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_deadbands = deadbands;
+    m_state.clear();
+}
+
+void NodeStore::set(const std::string &name, double value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (stageLocked(name, value, now))
+    {
+        m_dirty = true;
+    }
+    else
+    {
+        m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (m_dirty && now - m_lastCommit > StaleCommitInterval)
+    {
+        // No ticks (paused engine, lost Tick samples): don't hide values indefinitely.
+        std::shared_ptr<const Snapshot> front = std::atomic_load(&m_front);
+        publishLocked(front->frame, front->time);
+    }
+}
+
+void NodeStore::setNow(const std::string &name, double value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_back[name] = value;
+    std::shared_ptr<const Snapshot> front = std::atomic_load(&m_front);
+    auto published = front->values.find(name);
+    if (published != front->values.end() && published->second == value)
+    {
+        // Status readings repeat; don't copy the snapshot for nothing.
+        return;
+    }
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*front);
+    next->values[name] = value;
+    std::atomic_store(&m_front, std::shared_ptr<const Snapshot>(std::move(next)));
+}
+
+void NodeStore::commit(int64_t frame, double time)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_dirty || frame <= std::atomic_load(&m_front)->frame)
+    {
+        return;
+    }
+    publishLocked(frame, time);
+}
+
+void NodeStore::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_back.clear();
+    m_state.clear();
+    publishLocked(0, 0.0);
+}
+
+std::shared_ptr<const NodeStore::Snapshot> NodeStore::snapshot() const
+{
+    return std::atomic_load(&m_front);
+}
+
+uint64_t NodeStore::suppressed() const
+{
+    return m_suppressed.load(std::memory_order_relaxed);
+}
+
+bool NodeStore::stageLocked(const std::string &name, double value, std::chrono::steady_clock::time_point now)
+{
+    auto it = m_back.find(name);
+    if (it == m_back.end())
+    {
+        m_back.emplace(name, value);
+        if (!m_deadbands.empty())
+        {
+            m_state[name] = NodeState{m_deadbands.find(name), now};
+        }
+        return true;
+    }
+    if (it->second == value)
+    {
+        return false;
+    }
+
+    if (!m_deadbands.empty())
+    {
+        // Created on first sight; only missing after setDeadbands() replaced the rules.
+        auto state = m_state.find(name);
+        if (state == m_state.end())
+        {
+            state = m_state.emplace(name, NodeState{m_deadbands.find(name), std::chrono::steady_clock::time_point()}).first;
+        }
+        const Deadband *band = state->second.band;
+        if (band != nullptr)
+        {
+            // Compared with the published value, not the previous sample, so a slow drift
+            // still shows once it adds up.
+            if (now - state->second.lastChange < band->minInterval || band->suppresses(it->second, value))
+            {
+                return false;
+            }
+        }
+        state->second.lastChange = now;
+    }
+    it->second = value;
+    return true;
+}
+
+void NodeStore::publishLocked(int64_t frame, double time)
+{
+    // The back buffer always holds the complete state; copy it into the spare snapshot.
+    // Map assignment reuses the spare's nodes, so once no reader holds the previous
+    // snapshot a commit does not allocate.
+    std::shared_ptr<Snapshot> next;
+    if (m_spare && m_spare.use_count() == 1)
+    {
+        next = std::move(m_spare);
+    }
+    else
+    {
+        next = std::make_shared<Snapshot>();
+    }
+    next->frame = frame;
+    next->time = time;
+    next->values = m_back;
+
+    std::shared_ptr<const Snapshot> previous = std::atomic_exchange(&m_front, std::shared_ptr<const Snapshot>(next));
+    // Keep the previous snapshot for reuse; const_pointer_cast is safe because only the
+    // store ever creates snapshots, and it only writes them once readers let go.
+    m_spare = std::const_pointer_cast<Snapshot>(previous);
+    m_dirty = false;
+    m_lastCommit = std::chrono::steady_clock::now();
+}
+
+NodeStore nodeStore;
+
+std::map<std::string, std::string> statusStorage = {
+    {"STATUS", "NOT RUNNING"},
+    {"TICK", "0"},
+    {"TIME", "0"},
+    {"SCENARIO", ""},
+    {"STATE", ""},
+    {"AIR_SUPPLY", ""},
+    {"CLEAR_SUPPLY", ""},
+    {"BLOOD_SUPPLY", ""},
+    {"FLUIDICS_STATE", ""},
+    {"BATTERY1", ""},
+    {"BATTERY2", ""},
+    {"EXT_POWER", ""},
+    {"IVARM_STATE", ""},
+    {"MONITOR_ECG", ""},
+    {"MONITOR_PULSEOX", ""},
+    {"MONITOR_NIBP", ""},
+    {"MONITOR_TEMP", ""},
+    {"MONITOR_ARTLINE", ""},
+    {"MONITOR_ETCO2", ""},
+};
+std::vector<std::string> labsStorage;
+
+int64_t lastTick = 0;
+
+void ResetLabs()
+{
+    labsStorage.clear();
+    std::ostringstream labRow;
+
+    labRow << "Time,";
+
+    // POCT
+    labRow << "POCT,";
+    labRow << "Sodium (Na),";
+    labRow << "Potassium (K),";
+    labRow << "Chloride (Cl),";
+    labRow << "TCO2,";
+    labRow << "Anion Gap,";             // Anion Gap
+    labRow << "Ionized Calcium (iCa),"; // Ionized Calcium (iCa)
+    labRow << "Glucose (Glu),";
+    labRow << "Urea Nitrogen (BUN)/Urea,";
+    labRow << "Creatinine (Crea),";
+
+    // Hematology
+    labRow << "Hematology,";
+    labRow << "Hematocrit (Hct),";
+    labRow << "Hemoglobin (Hgb),";
+
+    // ABG
+    labRow << "ABG,";
+    labRow << "Lactate,";
+    labRow << "pH,";
+    labRow << "modified_pH,";
+    labRow << "PCO2,";
+    labRow << "PO2,";
+    labRow << "TCO2,";
+    labRow << "HCO3,";
+    labRow << "Base Excess (BE),";
+    labRow << "SpO2,";
+    labRow << "COHb,";
+
+    // VBG
+    labRow << "VBG,";
+    labRow << "Lactate,";
+    labRow << "pH,";
+    labRow << "PCO2,";
+    labRow << "TCO2,";
+    labRow << "HCO3,";
+    labRow << "Base Excess (BE),";
+    labRow << "COHb,";
+
+    // BMP
+    labRow << "BMP,";
+    labRow << "Sodium (Na),";
+    labRow << "Potassium (K),";
+    labRow << "Chloride (Cl),";
+    labRow << "TCO2,";
+    labRow << "Anion Gap,";             // Anion Gap
+    labRow << "Ionized Calcium (iCa),"; // Ionized Calcium (iCa)
+    labRow << "Glucose (Glu),";
+    labRow << "Urea Nitrogen (BUN)/Urea,";
+    labRow << "Creatinine (Crea),";
+
+    // CBC
+    labRow << "CBC,";
+    labRow << "WBC,";
+    labRow << "RBC,";
+    labRow << "Hgb,";
+    labRow << "Hct,";
+    labRow << "Plt,";
+
+    // CMP
+    labRow << "CMP,";
+    labRow << "Albumin,";
+    labRow << "ALP,"; // ALP
+    labRow << "ALT,"; // ALT
+    labRow << "AST,"; // AST
+    labRow << "BUN,";
+    labRow << "Calcium,";
+    labRow << "Chloride,";
+    labRow << "CO2,";
+    labRow << "Creatinine (men),";
+    labRow << "Creatinine (women),";
+    labRow << "Glucose,";
+    labRow << "Potassium,";
+    labRow << "Sodium,";
+    labRow << "Total bilirubin,";
+    labRow << "Total protein";
+    labsStorage.push_back(labRow.str());
+}
+
+void AppendLabRow()
+{
+    std::shared_ptr<const NodeStore::Snapshot> nodes = nodeStore.snapshot();
+    std::ostringstream labRow;
+
+    labRow << nodes->value("SIM_TIME") << ",";
+
+    // POCT
+    labRow << "POCT,";
+    labRow << nodes->value("Substance_Sodium") << ",";
+    labRow << nodes->value("MetabolicPanel_Potassium") << ",";
+    labRow << nodes->value("MetabolicPanel_Chloride") << ",";
+    labRow << nodes->value("MetabolicPanel_CarbonDioxide") << ",";
+    labRow << ","; // Anion Gap
+    labRow << ","; // Ionized Calcium (iCa)
+    labRow << nodes->value("Substance_Glucose_Concentration") << ",";
+    labRow << nodes->value("BloodChemistry_BloodUreaNitrogen_Concentration") << ",";
+    labRow << nodes->value("Substance_Creatinine_Concentration") << ",";
+
+    // Hematology
+    labRow << "Hematology,";
+    labRow << nodes->value("BloodChemistry_Hemaocrit") << ",";
+    labRow << nodes->value("Substance_Hemoglobin_Concentration") << ",";
+
+    // ABG
+    labRow << "ABG,";
+    labRow << nodes->value("Substance_Lactate_Concentration_mmol") << ",";
+    labRow << nodes->value("BloodChemistry_BloodPH") << ",";
+    labRow << nodes->value("BloodChemistry_BloodPH_MOD") << ",";
+    labRow << nodes->value("BloodChemistry_Arterial_CarbonDioxide_Pressure") << ",";
+    labRow << nodes->value("BloodChemistry_Arterial_Oxygen_Pressure") << ",";
+    labRow << nodes->value("MetabolicPanel_CarbonDioxide") << ",";
+    labRow << nodes->value("Substance_Bicarbonate") << ",";
+    labRow << nodes->value("Substance_BaseExcess") << ",";
+    labRow << nodes->value("BloodChemistry_Oxygen_Saturation") << ",";
+    labRow << nodes->value("Substance_Carboxyhemoglobin_Concentration") << ",";
+
+    // VBG
+    labRow << "VBG,";
+    labRow << nodes->value("Substance_Lactate_Concentration_mmol") << ",";
+    labRow << nodes->value("BloodChemistry_BloodPH") << ",";
+    labRow << nodes->value("BloodChemistry_VenousCarbonDioxidePressure") << ",";
+    labRow << nodes->value("MetabolicPanel_CarbonDioxide") << ",";
+    labRow << nodes->value("Substance_Bicarbonate") << ",";
+    labRow << nodes->value("Substance_BaseExcess") << ",";
+    labRow << nodes->value("Substance_Carboxyhemoglobin_Concentration") << ",";
+
+    // BMP
+    labRow << "BMP,";
+    labRow << nodes->value("Substance_Sodium") << ",";
+    labRow << nodes->value("MetabolicPanel_Potassium") << ",";
+    labRow << nodes->value("MetabolicPanel_Chloride") << ",";
+    labRow << nodes->value("MetabolicPanel_CarbonDioxide") << ",";
+    labRow << ","; // Anion Gap
+    labRow << ","; // Ionized Calcium (iCa)
+    labRow << nodes->value("Substance_Glucose_Concentration") << ",";
+    labRow << nodes->value("BloodChemistry_BloodUreaNitrogen_Concentration") << ",";
+    labRow << nodes->value("Substance_Creatinine_Concentration") << ",";
+
+    // CBC
+    labRow << "CBC,";
+    labRow << nodes->value("BloodChemistry_WhiteBloodCell_Count") << ",";
+    labRow << nodes->value("BloodChemistry_RedBloodCell_Count") << ",";
+    labRow << nodes->value("Substance_Hemoglobin_Concentration") << ",";
+    labRow << nodes->value("BloodChemistry_Hemaocrit") << ",";
+    labRow << nodes->value("CompleteBloodCount_Platelet") << ",";
+
+    // CMP
+    labRow << "CMP,";
+    labRow << nodes->value("Substance_Albumin_Concentration") << ",";
+    labRow << ","; // ALP
+    labRow << ","; // ALT
+    labRow << ","; // AST
+    labRow << nodes->value("BloodChemistry_BloodUreaNitrogen_Concentration") << ",";
+    labRow << nodes->value("Substance_Calcium_Concentration") << ",";
+    labRow << nodes->value("MetabolicPanel_Chloride") << ",";
+    labRow << nodes->value("MetabolicPanel_CarbonDioxide") << ",";
+    labRow << nodes->value("Substance_Creatinine_Concentration") << ",";
+    labRow << nodes->value("Substance_Creatinine_Concentration") << ",";
+    labRow << nodes->value("Substance_Glucose_Concentration") << ",";
+    labRow << nodes->value("MetabolicPanel_Potassium") << ",";
+    labRow << nodes->value("Substance_Sodium") << ",";
+    labRow << nodes->value("MetabolicPanel_Bilirubin") << ",";
+    labRow << nodes->value("MetabolicPanel_Protein");
+    labsStorage.push_back(labRow.str());
+}
+
+void WriteNodes(rapidjson::Writer<rapidjson::StringBuffer> &writer, const NodeStore::Snapshot &nodes)
+{
+    writer.StartArray();
+
+    auto nit = nodes.values.begin();
+    while (nit != nodes.values.end())
+    {
+        writer.StartObject();
+        writer.Key(nit->first.c_str());
+        writer.Double(nit->second);
+        writer.EndObject();
+        ++nit;
+    }
+
+    auto sit = statusStorage.begin();
+    while (sit != statusStorage.end())
+    {
+        writer.StartObject();
+        writer.Key(sit->first.c_str());
+        writer.String(sit->second.c_str());
+        writer.EndObject();
+        ++sit;
+    }
+
+    writer.EndArray();
+}
+
+std::string LabsReport()
+{
+    return boost::algorithm::join(labsStorage, "\n");
+}
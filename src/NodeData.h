@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include "Deadbands.h"
+
+/// Physiology values by node path, published one frame at a time.
+///
+/// The listener stages values into a back buffer as they arrive and commit() publishes
+/// them together when a Tick advances the frame, so readers never see heart rate from
+/// one frame next to blood pressure from the previous one. Readers take an immutable
+/// snapshot without locking; ingest only contends with the commit once per tick.
+///
+/// A value that does not move past its deadband is not staged, and a frame that stages
+/// nothing is not published, so readers keep the previous snapshot.
+class NodeStore
+{
+public:
+    struct Snapshot
+    {
+        int64_t frame = 0;
+        double time = 0.0;
+        std::map<std::string, double> values;
+
+        /// The node's value, or 0 if it has not been published.
+        double value(const std::string &name) const;
+    };
+
+    NodeStore();
+
+    /// Applies deadbands to later calls of set(). Configured once at startup.
+    void setDeadbands(const Deadbands &deadbands);
+
+    /// Stages a value for the next commit, unless it is unchanged or within its deadband.
+    void set(const std::string &name, double value);
+
+    /// Stages a value and publishes it at once, without the other staged values. For
+    /// values that do not come from the physiology frame (e.g. module status readings).
+    void setNow(const std::string &name, double value);
+
+    /// Publishes the staged values as the given frame. Ignored for a frame that is not
+    /// newer than the published one, or when nothing was staged since the last commit.
+    void commit(int64_t frame, double time);
+
+    /// Drops staged and published values (simulation reset).
+    void clear();
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    /// Values passed to set() that were unchanged or within their deadband.
+    uint64_t suppressed() const;
+
+private:
+    /// Deadband of a node and when it last changed, kept only while deadbands are set.
+    struct NodeState
+    {
+        const Deadband *band = nullptr;
+        std::chrono::steady_clock::time_point lastChange;
+    };
+
+    /// Staged values are published anyway if no tick arrives for this long.
+    static constexpr std::chrono::milliseconds StaleCommitInterval{1000};
+
+    bool stageLocked(const std::string &name, double value, std::chrono::steady_clock::time_point now);
+    void publishLocked(int64_t frame, double time);
+
+    std::mutex m_mutex;
+    std::map<std::string, double> m_back;
+    bool m_dirty = false;
+    std::chrono::steady_clock::time_point m_lastCommit;
+    std::shared_ptr<const Snapshot> m_front;
+    std::shared_ptr<Snapshot> m_spare;
+    Deadbands m_deadbands;
+    std::unordered_map<std::string, NodeState> m_state;
+    std::atomic<uint64_t> m_suppressed{0};
+};
+
+extern NodeStore nodeStore;
+
+/// Simulation and equipment state served alongside the nodes.
+extern std::map<std::string, std::string> statusStorage;
+
+/// Lab report rows; the first row is the CSV header.
+extern std::vector<std::string> labsStorage;
+
+extern int64_t lastTick;
+
+/// Resets database tables for labs.
+void ResetLabs();
+
+/// Add to database tables for labs.
+void AppendLabRow();
+
+/// The /nodes array: one {name: value} object per node, then one per status entry.
+void WriteNodes(rapidjson::Writer<rapidjson::StringBuffer> &writer, const NodeStore::Snapshot &nodes);
+
+/// The lab rows as a CSV document.
+std::string LabsReport();
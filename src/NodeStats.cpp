@@ -0,0 +1,87 @@
+#include "NodeStats.h"
+
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+namespace
+{
+    int64_t WallNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /// The rate average, decayed over the nanoseconds since its last update.
+    double Decayed(double rate, int64_t elapsedNs)
+    {
+        if (elapsedNs <= 0)
+        {
+            return rate;
+        }
+        return rate * std::exp(-static_cast<double>(elapsedNs) / 1e9 / NodeStats::RateTauSeconds);
+    }
+}
+
+void NodeStats::record(const std::string &name)
+{
+    Counters &c = counters(name);
+    int64_t now = WallNowNs();
+    int64_t last = c.lastNs.load(std::memory_order_relaxed);
+
+    // Each sample adds 1/tau to an exponentially decaying sum, which tracks the sample
+    // rate without a timer. A node is normally published from one thread; if two race,
+    // one of their increments to the average is lost, which the counter does not suffer.
+    double rate = last > 0 ? Decayed(c.rate.load(std::memory_order_relaxed), now - last) : 0.0;
+    c.rate.store(rate + 1.0 / RateTauSeconds, std::memory_order_relaxed);
+    c.lastNs.store(now, std::memory_order_relaxed);
+    c.simTime.store(m_simTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    c.samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NodeStats::setSimTime(double time)
+{
+    m_simTime.store(time, std::memory_order_relaxed);
+}
+
+std::vector<NodeStats::NodeSnapshot> NodeStats::snapshot() const
+{
+    std::vector<NodeSnapshot> nodes;
+    int64_t now = WallNowNs();
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    nodes.reserve(m_nodes.size());
+    for (const auto &entry : m_nodes)
+    {
+        const Counters &c = *entry.second;
+        NodeSnapshot node;
+        node.name = entry.first;
+        node.samples = c.samples.load(std::memory_order_relaxed);
+        node.lastUpdateNs = c.lastNs.load(std::memory_order_relaxed);
+        node.ageNs = node.lastUpdateNs > 0 ? now - node.lastUpdateNs : 0;
+        node.rateHz = Decayed(c.rate.load(std::memory_order_relaxed), node.ageNs);
+        node.simTime = c.simTime.load(std::memory_order_relaxed);
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+NodeStats::Counters &NodeStats::counters(const std::string &name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_nodes.find(name);
+        if (it != m_nodes.end())
+        {
+            return *it->second;
+        }
+    }
+    // Entries are never removed, so the reference stays valid once the lock is released.
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    std::unique_ptr<Counters> &slot = m_nodes[name];
+    if (!slot)
+    {
+        slot.reset(new Counters);
+    }
+    return *slot;
+}
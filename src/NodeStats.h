@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Per-node ingest profile: how many samples each physiology node received, its
+/// exponentially weighted rate, and the wall and simulation time of its last update.
+/// Served at /stats/nodes to find nodes that stopped updating or are republished far
+/// more often than the engine ticks.
+///
+/// Counters are updated with relaxed atomics from the DDS thread. The name index takes an
+/// exclusive lock only the first time a node is seen; every later sample takes it shared.
+class NodeStats
+{
+public:
+    /// Time constant of the rate average. A node that stops publishing decays to 1/e of
+    /// its rate after this long.
+    static constexpr double RateTauSeconds = 5.0;
+
+    struct NodeSnapshot
+    {
+        std::string name;
+        uint64_t samples;
+        double rateHz;
+        int64_t lastUpdateNs;
+        int64_t ageNs;
+        double simTime;
+    };
+
+    /// Counts one sample of a node, stamped with the current wall time and the last
+    /// simulation time passed to setSimTime.
+    void record(const std::string &name);
+
+    /// Simulation time of the current frame, taken from the Tick topic.
+    void setSimTime(double time);
+
+    /// All nodes seen so far, with their rate decayed up to now.
+    std::vector<NodeSnapshot> snapshot() const;
+
+private:
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> samples{0};
+        std::atomic<int64_t> lastNs{0};
+        std::atomic<double> rate{0.0};
+        std::atomic<double> simTime{0.0};
+    };
+
+    Counters &counters(const std::string &name);
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Counters>> m_nodes;
+    std::atomic<double> m_simTime{0.0};
+};
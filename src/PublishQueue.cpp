@@ -0,0 +1,175 @@
+#include "PublishQueue.h"
+
+#include <exception>
+
+#include "amm/BaseLogger.h"
+
+PublishQueue::PublishQueue(std::size_t capacity, std::size_t maxBatch)
+    : m_queue(capacity), m_maxBatch(maxBatch > 0 ? maxBatch : 1)
+{
+}
+
+PublishQueue::~PublishQueue()
+{
+    stop();
+}
+
+void PublishQueue::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+    m_thread = std::thread(&PublishQueue::run, this);
+}
+
+void PublishQueue::stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+    m_thread.join();
+
+    // An enqueue that saw m_running before the exchange may still be pushing. Wait for it,
+    // then fail what it pushed after the publisher's final drain so no completion is lost.
+    while (m_producers.load(std::memory_order_seq_cst) > 0)
+    {
+        std::this_thread::yield();
+    }
+    Item item;
+    while (m_queue.tryPop(item))
+    {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+        if (item.done)
+        {
+            item.done(false);
+        }
+        item = Item();
+    }
+}
+
+bool PublishQueue::enqueue(Publish publish, Completion done)
+{
+    // Announce the push before checking m_running; stop() waits for announced pushes
+    // after clearing it (seq_cst on both sides).
+    m_producers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_running.load(std::memory_order_seq_cst))
+    {
+        m_producers.fetch_sub(1, std::memory_order_release);
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Item item{std::move(publish), std::move(done), std::chrono::steady_clock::now()};
+    bool pushed = m_queue.tryPush(std::move(item));
+    m_producers.fetch_sub(1, std::memory_order_release);
+    if (!pushed)
+    {
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_enqueued.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in run(): either the publisher sees the item before it
+    // sleeps, or we see it sleeping and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cond.notify_one();
+    }
+    return true;
+}
+
+PublishQueue::Stats PublishQueue::stats() const
+{
+    Stats s;
+    s.depth = m_queue.sizeApprox();
+    s.capacity = m_queue.capacity();
+    s.enqueued = m_enqueued.load(std::memory_order_relaxed);
+    s.published = m_published.load(std::memory_order_relaxed);
+    s.failed = m_failed.load(std::memory_order_relaxed);
+    s.rejected = m_rejected.load(std::memory_order_relaxed);
+    s.batches = m_batches.load(std::memory_order_relaxed);
+    s.lastLatencyUs = m_lastLatencyUs.load(std::memory_order_relaxed);
+    s.maxLatencyUs = m_maxLatencyUs.load(std::memory_order_relaxed);
+    uint64_t done = s.published + s.failed;
+    s.meanLatencyUs = done > 0 ? static_cast<double>(m_totalLatencyUs.load(std::memory_order_relaxed)) / done : 0.0;
+    return s;
+}
+
+void PublishQueue::run()
+{
+    while (m_running.load(std::memory_order_acquire))
+    {
+        if (drain() > 0)
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_cond.wait_for(lock, std::chrono::milliseconds(100), [this]
+                        { return !m_queue.emptyApprox() || !m_running.load(std::memory_order_acquire); });
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+
+    // Publish whatever was accepted before the stop.
+    while (drain() > 0)
+    {
+    }
+}
+
+std::size_t PublishQueue::drain()
+{
+    std::size_t count = 0;
+    Item item;
+    while (count < m_maxBatch && m_queue.tryPop(item))
+    {
+        bool ok = true;
+        try
+        {
+            item.publish();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Publish failed: " << e.what();
+            ok = false;
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Publish failed with an unknown exception";
+            ok = false;
+        }
+
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - item.enqueued)
+                           .count();
+        uint64_t us = static_cast<uint64_t>(latency);
+        m_lastLatencyUs.store(us, std::memory_order_relaxed);
+        m_totalLatencyUs.fetch_add(us, std::memory_order_relaxed);
+        if (us > m_maxLatencyUs.load(std::memory_order_relaxed))
+        {
+            m_maxLatencyUs.store(us, std::memory_order_relaxed);
+        }
+        (ok ? m_published : m_failed).fetch_add(1, std::memory_order_relaxed);
+
+        if (item.done)
+        {
+            item.done(ok);
+        }
+        item = Item();
+        ++count;
+    }
+    if (count > 0)
+    {
+        m_batches.fetch_add(1, std::memory_order_relaxed);
+    }
+    return count;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "BoundedQueue.h"
+
+/// Decouples DDS writes from HTTP handlers. Handlers enqueue a publish closure and
+/// return; a dedicated publisher thread drains the queue in batches, in order.
+class PublishQueue
+{
+public:
+    typedef std::function<void()> Publish;
+
+    /// Called on the publisher thread once the publish ran; false if it threw.
+    typedef std::function<void(bool)> Completion;
+
+    struct Stats
+    {
+        std::size_t depth;
+        std::size_t capacity;
+        uint64_t enqueued;
+        uint64_t published;
+        uint64_t failed;
+        uint64_t rejected;
+        uint64_t batches;
+        uint64_t lastLatencyUs;
+        uint64_t maxLatencyUs;
+        double meanLatencyUs;
+    };
+
+    explicit PublishQueue(std::size_t capacity = 1024, std::size_t maxBatch = 64);
+    ~PublishQueue();
+
+    PublishQueue(const PublishQueue &) = delete;
+    PublishQueue &operator=(const PublishQueue &) = delete;
+
+    void start();
+
+    /// Publishes everything queued before the stop and joins the publisher thread. A
+    /// publish that raced with the stop is failed, so its completion still runs.
+    void stop();
+
+    /// Queues a publish; returns false if the queue is full or stopped.
+    bool enqueue(Publish publish, Completion done = Completion());
+
+    Stats stats() const;
+
+private:
+    struct Item
+    {
+        Publish publish;
+        Completion done;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void run();
+    std::size_t drain();
+
+    BoundedQueue<Item> m_queue;
+    std::size_t m_maxBatch;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<bool> m_sleeping{false};
+    std::atomic<bool> m_running{false};
+    /// Enqueues between their m_running check and the push.
+    std::atomic<int> m_producers{0};
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_enqueued{0};
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_batches{0};
+    std::atomic<uint64_t> m_lastLatencyUs{0};
+    std::atomic<uint64_t> m_maxLatencyUs{0};
+    std::atomic<uint64_t> m_totalLatencyUs{0};
+};
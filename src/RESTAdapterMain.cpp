@@ -6,6 +6,13 @@
 #include <condition_variable>
 #include <stdexcept>
 
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
 #include "amm_std.h"
 
 #include "amm/BaseLogger.h"
@@ -19,11 +26,29 @@
 #include "rapidjson/writer.h"
 
 #include "boost/filesystem.hpp"
-#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/process.hpp>
 
 #include "thirdparty/sqlite_modern_cpp.h"
 
+#include "AdmissionControl.h"
+#include "AsyncLogAppender.h"
+#include "AtomicFile.h"
+#include "CsvExport.h"
+#include "DdsStats.h"
+#include "Deadbands.h"
+#include "Download.h"
+#include "HttpMetrics.h"
+#include "JsonRequest.h"
+#include "NodeData.h"
+#include "NodeStats.h"
+#include "PublishQueue.h"
+#include "RequestContext.h"
+#include "RESTListener.h"
+#include "ResponseBuffer.h"
+#include "WorkerPool.h"
+
 using namespace AMM;
 using namespace std;
 using namespace std::chrono;
@@ -37,564 +62,67 @@ using namespace sqlite;
 /// REST adapter port.
 int portNumber = 9080;
 
-/// REST threads.
+/// REST threads (per listener).
 int thr = 2;
 
-/// Daemonize by default.
-int daemonize = 1;
-
-/// Default discovery.
-int discovery = 1;
-
-/// Hostname to connect to.
-char hostname[HOST_NAME_MAX];
-
-std::string action_path = "Actions/";
-std::string state_path = "./states/";
-std::string patient_path = "./patients/";
-std::string scenario_path = "./static/scenarios/";
-
-std::mutex nds_mutex;
-std::map<std::string, double> nodeDataStorage;
-
-std::map<std::string, std::string> statusStorage = {
-    {"STATUS", "NOT RUNNING"},
-    {"TICK", "0"},
-    {"TIME", "0"},
-    {"SCENARIO", ""},
-    {"STATE", ""},
-    {"AIR_SUPPLY", ""},
-    {"CLEAR_SUPPLY", ""},
-    {"BLOOD_SUPPLY", ""},
-    {"FLUIDICS_STATE", ""},
-    {"BATTERY1", ""},
-    {"BATTERY2", ""},
-    {"EXT_POWER", ""},
-    {"IVARM_STATE", ""},
-    {"MONITOR_ECG", ""},
-    {"MONITOR_PULSEOX", ""},
-    {"MONITOR_NIBP", ""},
-    {"MONITOR_TEMP", ""},
-    {"MONITOR_ARTLINE", ""},
-    {"MONITOR_ETCO2", ""},
-};
-std::vector<std::string> labsStorage;
-
-bool m_runThread = false;
-int64_t lastTick = 0;
-
-const string sysPrefix = "[SYS]";
-const string actPrefix = "[ACT]";
-const string loadScenarioPrefix = "LOAD_SCENARIO:";
-const string loadPrefix = "LOAD_STATE:";
-const string loadPatientPrefix = "LOAD_PATIENT:";
-
-void SendReset();
-
-/// Resets database tables for labs.
-void ResetLabs()
-{
-    labsStorage.clear();
-    std::ostringstream labRow;
-
-    labRow << "Time,";
-
-    // POCT
-    labRow << "POCT,";
-    labRow << "Sodium (Na),";
-    labRow << "Potassium (K),";
-    labRow << "Chloride (Cl),";
-    labRow << "TCO2,";
-    labRow << "Anion Gap,";             // Anion Gap
-    labRow << "Ionized Calcium (iCa),"; // Ionized Calcium (iCa)
-    labRow << "Glucose (Glu),";
-    labRow << "Urea Nitrogen (BUN)/Urea,";
-    labRow << "Creatinine (Crea),";
-
-    // Hematology
-    labRow << "Hematology,";
-    labRow << "Hematocrit (Hct),";
-    labRow << "Hemoglobin (Hgb),";
-
-    // ABG
-    labRow << "ABG,";
-    labRow << "Lactate,";
-    labRow << "pH,";
-    labRow << "modified_pH,";
-    labRow << "PCO2,";
-    labRow << "PO2,";
-    labRow << "TCO2,";
-    labRow << "HCO3,";
-    labRow << "Base Excess (BE),";
-    labRow << "SpO2,";
-    labRow << "COHb,";
-
-    // VBG
-    labRow << "VBG,";
-    labRow << "Lactate,";
-    labRow << "pH,";
-    labRow << "PCO2,";
-    labRow << "TCO2,";
-    labRow << "HCO3,";
-    labRow << "Base Excess (BE),";
-    labRow << "COHb,";
-
-    // BMP
-    labRow << "BMP,";
-    labRow << "Sodium (Na),";
-    labRow << "Potassium (K),";
-    labRow << "Chloride (Cl),";
-    labRow << "TCO2,";
-    labRow << "Anion Gap,";             // Anion Gap
-    labRow << "Ionized Calcium (iCa),"; // Ionized Calcium (iCa)
-    labRow << "Glucose (Glu),";
-    labRow << "Urea Nitrogen (BUN)/Urea,";
-    labRow << "Creatinine (Crea),";
-
-    // CBC
-    labRow << "CBC,";
-    labRow << "WBC,";
-    labRow << "RBC,";
-    labRow << "Hgb,";
-    labRow << "Hct,";
-    labRow << "Plt,";
-
-    // CMP
-    labRow << "CMP,";
-    labRow << "Albumin,";
-    labRow << "ALP,"; // ALP
-    labRow << "ALT,"; // ALT
-    labRow << "AST,"; // AST
-    labRow << "BUN,";
-    labRow << "Calcium,";
-    labRow << "Chloride,";
-    labRow << "CO2,";
-    labRow << "Creatinine (men),";
-    labRow << "Creatinine (women),";
-    labRow << "Glucose,";
-    labRow << "Potassium,";
-    labRow << "Sodium,";
-    labRow << "Total bilirubin,";
-    labRow << "Total protein";
-    labsStorage.push_back(labRow.str());
-}
-
-/// Add to database tables for labs.
-void AppendLabRow()
-{
-    std::ostringstream labRow;
-
-    labRow << nodeDataStorage["SIM_TIME"] << ",";
-
-    // POCT
-    labRow << "POCT,";
-    labRow << nodeDataStorage["Substance_Sodium"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Potassium"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Chloride"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_CarbonDioxide"] << ",";
-    labRow << ","; // Anion Gap
-    labRow << ","; // Ionized Calcium (iCa)
-    labRow << nodeDataStorage["Substance_Glucose_Concentration"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_BloodUreaNitrogen_Concentration"] << ",";
-    labRow << nodeDataStorage["Substance_Creatinine_Concentration"] << ",";
-
-    // Hematology
-    labRow << "Hematology,";
-    labRow << nodeDataStorage["BloodChemistry_Hemaocrit"] << ",";
-    labRow << nodeDataStorage["Substance_Hemoglobin_Concentration"] << ",";
-
-    // ABG
-    labRow << "ABG,";
-    labRow << nodeDataStorage["Substance_Lactate_Concentration_mmol"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_BloodPH"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_BloodPH_MOD"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_Arterial_CarbonDioxide_Pressure"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_Arterial_Oxygen_Pressure"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_CarbonDioxide"] << ",";
-    labRow << nodeDataStorage["Substance_Bicarbonate"] << ",";
-    labRow << nodeDataStorage["Substance_BaseExcess"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_Oxygen_Saturation"] << ",";
-    labRow << nodeDataStorage["Substance_Carboxyhemoglobin_Concentration"] << ",";
-
-    // VBG
-    labRow << "VBG,";
-    labRow << nodeDataStorage["Substance_Lactate_Concentration_mmol"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_BloodPH"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_VenousCarbonDioxidePressure"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_CarbonDioxide"] << ",";
-    labRow << nodeDataStorage["Substance_Bicarbonate"] << ",";
-    labRow << nodeDataStorage["Substance_BaseExcess"] << ",";
-    labRow << nodeDataStorage["Substance_Carboxyhemoglobin_Concentration"] << ",";
-
-    // BMP
-    labRow << "BMP,";
-    labRow << nodeDataStorage["Substance_Sodium"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Potassium"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Chloride"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_CarbonDioxide"] << ",";
-    labRow << ","; // Anion Gap
-    labRow << ","; // Ionized Calcium (iCa)
-    labRow << nodeDataStorage["Substance_Glucose_Concentration"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_BloodUreaNitrogen_Concentration"] << ",";
-    labRow << nodeDataStorage["Substance_Creatinine_Concentration"] << ",";
-
-    // CBC
-    labRow << "CBC,";
-    labRow << nodeDataStorage["BloodChemistry_WhiteBloodCell_Count"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_RedBloodCell_Count"] << ",";
-    labRow << nodeDataStorage["Substance_Hemoglobin_Concentration"] << ",";
-    labRow << nodeDataStorage["BloodChemistry_Hemaocrit"] << ",";
-    labRow << nodeDataStorage["CompleteBloodCount_Platelet"] << ",";
-
-    // CMP
-    labRow << "CMP,";
-    labRow << nodeDataStorage["Substance_Albumin_Concentration"] << ",";
-    labRow << ","; // ALP
-    labRow << ","; // ALT
-    labRow << ","; // AST
-    labRow << nodeDataStorage["BloodChemistry_BloodUreaNitrogen_Concentration"] << ",";
-    labRow << nodeDataStorage["Substance_Calcium_Concentration"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Chloride"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_CarbonDioxide"] << ",";
-    labRow << nodeDataStorage["Substance_Creatinine_Concentration"] << ",";
-    labRow << nodeDataStorage["Substance_Creatinine_Concentration"] << ",";
-    labRow << nodeDataStorage["Substance_Glucose_Concentration"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Potassium"] << ",";
-    labRow << nodeDataStorage["Substance_Sodium"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Bilirubin"] << ",";
-    labRow << nodeDataStorage["MetabolicPanel_Protein"];
-    labsStorage.push_back(labRow.str());
-}
+/// Listeners sharing the port through SO_REUSEPORT (0 = one per core).
+int listenerShards = 1;
 
-std::string ExtractTypeFromRenderMod(std::string payload)
-{
-    std::size_t pos = payload.find("type=");
-    if (pos != std::string::npos)
-    {
-        std::string p1 = payload.substr(pos + 6);
-        std::size_t pos2 = p1.find("\"");
-        if (pos2 != std::string::npos)
-        {
-            std::string p2 = p1.substr(0, pos2);
-            return p2;
-        }
-    }
-    return {};
-};
+/// Pin each listener and its event loop threads to one CPU.
+bool pinListeners = false;
 
-std::string ExtractManikinIDFromString(std::string in)
-{
-    std::size_t pos = in.find("mid=");
-    if (pos != std::string::npos)
-    {
-        std::string mid1 = in.substr(pos + 4);
-        std::size_t pos1 = mid1.find(";");
-        if (pos1 != std::string::npos)
-        {
-            std::string mid2 = mid1.substr(0, pos1);
-            return mid2;
-        }
-        return mid1;
-    }
-    return {};
-}
+/// Worker threads for blocking handlers (disk, SQLite, child processes).
+int workerThreads = 4;
 
-/// Core logic container for DDS Manager functions.
-class RESTListener : public ListenerInterface
-{
-public:
-    void onNewStatus(AMM::Status &st, SampleInfo_t *info)
-    {
-        ostringstream statusValue;
-        statusValue << AMM::Utility::EStatusValueStr(st.value());
+/// In-flight request limits per route class (0 = unlimited, bulk 0 = half the workers).
+int maxTelemetryRequests = 256;
+int maxControlRequests = 64;
+int maxBulkRequests = 0;
 
-        LOG_DEBUG << "[" << st.module_id().id() << "][" << st.module_name() << "]["
-                  << st.capability() << "] Status = " << statusValue.str() << " (" << st.value() << ")";
-        // Message = " << st.message();
+/// Largest accepted assessment upload.
+size_t maxUploadBytes = 256 * 1024 * 1024;
 
-        if (st.module_name() == "AMM_FluidManager" || st.module_name() == "Torso_Control")
-        {
-            if (st.capability() == "fluidics")
-            {
-                statusStorage["FLUIDICS_STATE"] = statusValue.str();
-            }
-            else if (st.capability() == "clear_supply")
-            {
-                statusStorage["CLEAR_SUPPLY"] = statusValue.str();
-            }
-            else if (st.capability() == "blood_supply")
-            {
-                statusStorage["BLOOD_SUPPLY"] = statusValue.str();
-            }
-            else if (st.capability() == "air_supply")
-            {
-                statusStorage["AIR_SUPPLY"] = statusValue.str();
-                // parse st.message() to double p; [p] = psi
-                try
-                {
-                    double p = std::stod(st.message());
-                    nodeDataStorage["Air_Pressure"] = p;
-                }
-                catch (const std::invalid_argument &)
-                {
-                    nodeDataStorage["Air_Pressure"] = 0.0;
-                }
-                catch (const std::out_of_range &)
-                {
-                }
-            }
-        }
+/// Port for assessment uploads larger than the main port accepts (0 = no upload port).
+int uploadPortNumber = 9081;
 
-        if (st.module_name() == "AJAMS_Services")
-        {
-            if (st.capability() == "battery-1")
-            {
-                statusStorage["BATTERY1"] = statusValue.str();
-                // parse st.message() to double soc; [soc] = %
-                try
-                {
-                    double soc = std::stod(st.message());
-                    nodeDataStorage["Battery1_SOC"] = soc;
-                }
-                catch (const std::invalid_argument &)
-                {
-                    nodeDataStorage["Battery1_SOC"] = 0.0;
-                }
-                catch (const std::out_of_range &)
-                {
-                }
-            }
-            else if (st.capability() == "battery-2")
-            {
-                statusStorage["BATTERY2"] = statusValue.str();
-                // parse st.message() to double soc; [soc] = %
-                try
-                {
-                    double soc = std::stod(st.message());
-                    nodeDataStorage["Battery2_SOC"] = soc;
-                }
-                catch (const std::invalid_argument &)
-                {
-                    nodeDataStorage["Battery2_SOC"] = 0.0;
-                }
-                catch (const std::out_of_range &)
-                {
-                }
-            }
-            else if (st.capability() == "ext_power")
-            {
-                statusStorage["EXT_POWER"] = statusValue.str();
-            }
-        }
+/// Capacity of the DDS publish queue.
+int publishQueueCapacity = 1024;
 
-        if (st.capability() == "iv_detection")
-        {
-            statusStorage["IVARM_STATE"] = statusValue.str();
-        }
-    }
+/// Trace the stages of one in every n requests (0 = off).
+int traceSampleEvery = 100;
 
-    void onNewTick(AMM::Tick &t, SampleInfo_t *info)
-    {
-        if (statusStorage["STATUS"].compare("NOT RUNNING") == 0 &&
-            t.frame() > lastTick)
-        {
-            statusStorage["STATUS"] = "RUNNING";
-        }
-        lastTick = t.frame();
-        statusStorage["TICK"] = to_string(t.frame());
-        statusStorage["TIME"] = to_string(t.time());
-    }
+/// Log file, rotated by the async appender (empty = console).
+std::string logFile;
 
-    void onNewSimulationControl(AMM::SimulationControl &simControl, SampleInfo_t *info)
-    {
-        switch (simControl.type())
-        {
-        case AMM::ControlType::RUN:
-        {
-            statusStorage["STATUS"] = "RUNNING";
-            LOG_DEBUG << "SimControl received: Run sim.";
-            break;
-        }
+/// Initial log level; adjustable at runtime through /admin/log_level.
+std::string logLevel = "verbose";
 
-        case AMM::ControlType::HALT:
-        {
-            statusStorage["STATUS"] = "PAUSED";
-            break;
-        }
+/// Seconds to wait for in-flight requests when shutting down.
+int drainSeconds = 10;
 
-        case AMM::ControlType::RESET:
-        {
-            LOG_DEBUG
-                << "SimControl received: Reset simulation, clean up and prepare for next run.";
-            statusStorage["STATUS"] = "NOT RUNNING";
-            statusStorage["TICK"] = "0";
-            statusStorage["TIME"] = "0";
-            nodeDataStorage.clear();
-            ResetLabs();
-            break;
-        }
-        }
-    }
+/// Which physiology nodes to ingest, their deadbands and the status routes (see
+/// IngestFilter, Deadbands and StatusMap).
+std::string ingestConfigFile = "config/rest_adapter_ingest.xml";
 
-    void onNewCommand(AMM::Command &c, SampleInfo_t *info)
-    {
-        std::string manikin_id = ExtractManikinIDFromString(c.message());
-        LOG_INFO << "Got a command: " << c.message() << " for manikin " << manikin_id;
-        if (!c.message().compare(0, sysPrefix.size(), sysPrefix))
-        {
-            std::string value = c.message().substr(sysPrefix.size());
-            if (value.find("START_SIM") != std::string::npos)
-            {
-                statusStorage["STATUS"] = "RUNNING";
-            }
-            else if (value.find("STOP_SIM") != std::string::npos)
-            {
-                statusStorage["STATUS"] = "STOPPED";
-            }
-            else if (value.find("PAUSE_SIM") != std::string::npos)
-            {
-                statusStorage["STATUS"] = "PAUSED";
-            }
-            else if (value.find("RESET_SIM") != std::string::npos)
-            {
-                statusStorage["STATUS"] = "NOT RUNNING";
-                statusStorage["TICK"] = "0";
-                statusStorage["TIME"] = "0";
-                nodeDataStorage.clear();
-                ResetLabs();
-            }
-            else if (value.find("END_SIMULATION") != std::string::npos)
-            {
-                statusStorage["STATUS"] = "STOPPED";
-                statusStorage["TICK"] = "0";
-                statusStorage["TIME"] = "0";
-                nodeDataStorage.clear();
-                ResetLabs();
-            }
-            else if (value.find("APPEND_LABS") != std::string::npos)
-            {
-                AppendLabRow();
-            }
-            else if (value.find("CLEAR_LOG") != std::string::npos)
-            {
-            }
-            else if (value.find("RESTART_SERVICE") != std::string::npos)
-            {
-                LOG_INFO << "Command: RESTART_SERVICE" << c.message();
-            }
-            else if (!value.compare(0, loadPrefix.size(), loadPrefix))
-            {
-                statusStorage["STATE"] = value.substr(loadPrefix.size());
-                SendReset();
-            }
-            else if (!value.compare(0, loadScenarioPrefix.size(),
-                                    loadScenarioPrefix))
-            {
-                statusStorage["SCENARIO"] = value.substr(loadScenarioPrefix.size());
-            }
-            else if (!value.compare(0, loadPatientPrefix.size(),
-                                    loadPatientPrefix))
-            {
-                statusStorage["PATIENT"] = value.substr(loadPatientPrefix.size());
-            }
-        }
-        else
-        {
-            // LOG_TRACE << "Unknown AMM Command: " << c.message();
-        }
-    }
+/// Daemonize by default.
+int daemonize = 1;
 
-    void onNewPhysiologyValue(AMM::PhysiologyValue &n, SampleInfo_t *info)
-    {
-      //      LOG_TRACE << "Getting physiology value: " << n.name() << " = " << n.value();
-        const std::lock_guard<std::mutex> lock(nds_mutex);
-        if (!isnan(n.value()))
-        {
-            nodeDataStorage[n.name()] = n.value();
-        }
-    }
+/// Default discovery.
+int discovery = 1;
 
-    void onNewRenderModification(AMM::RenderModification &rendMod, SampleInfo_t *info)
-    {
-        std::ostringstream messageOut;
-        messageOut << "[AMM_Render_Modification]"
-                   << "type=" << rendMod.type() << ";"
-                   << "payload=" << rendMod.data();
-        std::string stringOut = messageOut.str();
-        // LOG_DEBUG << "Render modification received from AMM: " << stringOut;
+/// Hostname to connect to.
+char hostname[HOST_NAME_MAX];
 
-        if (rendMod.type().compare("CONNECT_ECG") == 0)
-        {
-            statusStorage["MONITOR_ECG"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_ECG") == 0)
-        {
-            statusStorage["MONITOR_ECG"] = "OFF";
-        }
-        else if (rendMod.type().compare("CONNECT_PULSE_OX") == 0)
-        {
-            statusStorage["MONITOR_PULSEOX"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_PULSE_OX") == 0)
-        {
-            statusStorage["MONITOR_PULSEOX"] = "OFF";
-        }
-        else if (rendMod.type().compare("CONNECT_NIBP") == 0)
-        {
-            statusStorage["MONITOR_NIBP"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_NIBP") == 0)
-        {
-            statusStorage["MONITOR_NIBP"] = "OFF";
-        }
-        else if (rendMod.type().compare("CONNECT_TEMP_PROBE") == 0)
-        {
-            statusStorage["MONITOR_TEMP"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_TEMP_PROBE") == 0)
-        {
-            statusStorage["MONITOR_TEMP"] = "OFF";
-        }
-        else if (rendMod.type().compare("CONNECT_ART_LINE") == 0)
-        {
-            statusStorage["MONITOR_ARTLINE"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_ART_LINE") == 0)
-        {
-            statusStorage["MONITOR_ARTLINE"] = "OFF";
-        }
-        else if (rendMod.type().compare("CONNECT_ETCO2") == 0)
-        {
-            statusStorage["MONITOR_ETCO2"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_ETCO2") == 0)
-        {
-            statusStorage["MONITOR_ETCO2"] = "OFF";
-        }
-        else if (rendMod.type().compare("ATTACH_TO_PATIENT") == 0)
-        {
-            statusStorage["MONITOR_ECG"] = "ON";
-            statusStorage["MONITOR_PULSEOX"] = "ON";
-            statusStorage["MONITOR_NIBP"] = "ON";
-            statusStorage["MONITOR_TEMP"] = "ON";
-            statusStorage["MONITOR_ARTLINE"] = "ON";
-            statusStorage["MONITOR_ETCO2"] = "ON";
-        }
-        else if (rendMod.type().compare("DETACH_FROM_PATIENT") == 0)
-        {
-            statusStorage["MONITOR_ECG"] = "OFF";
-            statusStorage["MONITOR_PULSEOX"] = "OFF";
-            statusStorage["MONITOR_NIBP"] = "OFF";
-            statusStorage["MONITOR_TEMP"] = "OFF";
-            statusStorage["MONITOR_ARTLINE"] = "OFF";
-            statusStorage["MONITOR_ETCO2"] = "OFF";
-        }
-    }
-};
+std::string action_path = "Actions/";
+std::string state_path = "./states/";
+std::string patient_path = "./patients/";
+std::string scenario_path = "./static/scenarios/";
 
 const std::string moduleName = "AMM_REST_Adapter";
 const std::string configFile = "config/rest_adapter_amm.xml";
 DDSManager<RESTListener> *mgr;
+PublishQueue *publisher;
+AsyncLogAppender *logAppender;
 AMM::UUID m_uuid;
 
 database db("amm.db");
@@ -729,7 +257,7 @@ void SendCommand(const std::string &command)
             statusStorage["STATUS"] = "NOT RUNNING";
             statusStorage["TICK"] = "0";
             statusStorage["TIME"] = "0";
-            nodeDataStorage.clear();
+            nodeStore.clear();
             ResetLabs();
             AMM::SimulationControl simControl;
             auto ms = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
@@ -750,8 +278,23 @@ void SendCommand(const std::string &command)
             // Execute restart request here. Do not forward.
             // TODO: this functionality might be more appropriate for the module manager to handle
             //       the else statement below will forward. Module manager would receive the command and process
-            std::string command = "supervisorctl start amm_startup";
-            int result = boost::process::system(command);
+            // Commands are sent from the publisher thread, which must not wait on a child
+            // process: every queued publish would stall behind it. Only the spawn is moved
+            // to a helper thread; nothing is published for this command.
+            std::thread(
+                []()
+                {
+                    try
+                    {
+                        int result = boost::process::system("supervisorctl start amm_startup");
+                        LOG_INFO << "supervisorctl start amm_startup exited with " << result;
+                    }
+                    catch (const std::exception &e)
+                    {
+                        LOG_ERROR << "Unable to restart services: " << e.what();
+                    }
+                })
+                .detach();
         }
         else
         {
@@ -770,6 +313,48 @@ void SendCommand(const std::string &command)
     }
 }
 
+/// Turns a parsed command or modification into a publish closure. The fields are copied,
+/// since the parse arena they point into is reused by the next request.
+PublishQueue::Publish BuildPublish(const OperationFields &fields)
+{
+    std::string type(fields.type);
+    std::string location(fields.location);
+    std::string practitioner(fields.practitioner);
+    std::string payload(fields.payload);
+
+    switch (fields.kind)
+    {
+    case RequestKind::Command:
+        return [payload]() { SendCommand(payload); };
+    case RequestKind::PhysiologyModification:
+        return [type, location, practitioner, payload]()
+        {
+            AMM::UUID erID = SendEventRecord(location, practitioner, type);
+            SendPhysiologyModification(erID, type, payload);
+        };
+    case RequestKind::RenderModification:
+        return [type, location, practitioner, payload]()
+        {
+            AMM::UUID erID = SendEventRecord(location, practitioner, type);
+            SendRenderModification(erID, type, payload);
+        };
+    case RequestKind::PerformanceAssessment:
+    {
+        std::string info(fields.info);
+        std::string step(fields.step);
+        std::string comment(fields.comment);
+        return [type, location, practitioner, info, step, comment]()
+        {
+            AMM::UUID erID = SendEventRecord(location, practitioner, type);
+            SendPerformanceAssessment(erID, type, info, step, comment);
+        };
+    }
+    case RequestKind::Batch:
+        break;
+    }
+    return {};
+}
+
 void printCookies(const Http::Request &req)
 {
     auto cookies = req.cookies();
@@ -787,78 +372,364 @@ namespace Generic
 
     void handleReady(const Rest::Request &request, Http::ResponseWriter response)
     {
-        response.send(Http::Code::Ok, "1");
+        SendResponse(response, Http::Code::Ok, "1");
     }
 }
 
 class DDSEndpoint
 {
-    static constexpr size_t DefaultMaxPayload = 1024102410;
+    /// Largest body accepted by routes that take JSON or no body at all.
+    static constexpr size_t DefaultMaxBody = 64 * 1024;
+
+    /// Largest body accepted by /batch; the item count is capped by its schema.
+    static constexpr size_t MaxBatchBody = 256 * 1024;
+
+    /// Headroom on top of the largest route body for the request line and headers.
+    static constexpr size_t HeaderAllowance = 64 * 1024;
+
+    /// Largest body the main port buffers. Pistache reads the whole request before a route
+    /// can refuse it, so routes with a larger cap are also served on the upload port, the
+    /// only listener that buffers bodies of up to maxUploadBytes.
+    static constexpr size_t MaxMainBody = MaxBatchBody;
 
 public:
-    explicit DDSEndpoint(Address addr)
-        : httpEndpoint(std::make_shared<Http::Endpoint>(addr)) {}
+    explicit DDSEndpoint(Address addr) : address(addr) {}
 
-    void init(int thr = 2)
+    /// Creates the listeners. With more than one shard every listener binds the same
+    /// port with SO_REUSEPORT and the kernel load-balances accepted connections.
+    void init(int thr = 2, int workers = 4, int shards = 1)
     {
+        if (shards <= 0)
+        {
+            shards = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+
+        auto flags = Tcp::Options::ReuseAddr;
+        if (shards > 1)
+        {
+            flags = flags | Tcp::Options::ReusePort;
+        }
+
         auto opts = Http::Endpoint::options()
                         .threads(thr)
-                        .flags(Tcp::Options::ReuseAddr);
-        httpEndpoint->init(opts);
+                        .flags(flags)
+                        .maxRequestSize(MaxMainBody + HeaderAllowance);
+        for (int i = 0; i < shards; ++i)
+        {
+            auto endpoint = std::make_shared<Http::Endpoint>(address);
+            endpoint->init(opts);
+            httpEndpoints.push_back(endpoint);
+        }
+        if (uploadPortNumber > 0)
+        {
+            auto uploadOpts = Http::Endpoint::options()
+                                  .threads(1)
+                                  .flags(Tcp::Options::ReuseAddr)
+                                  .maxRequestSize(std::max(maxUploadBytes, MaxMainBody) + HeaderAllowance);
+            uploadEndpoint = std::make_shared<Http::Endpoint>(
+                Address(Ipv4::any(), Port(static_cast<uint16_t>(uploadPortNumber))));
+            uploadEndpoint->init(uploadOpts);
+        }
+        workerPool.start(static_cast<size_t>(workers));
+
+        admission.setLimit(RouteClass::Telemetry, maxTelemetryRequests);
+        admission.setLimit(RouteClass::Control, maxControlRequests);
+        admission.setLimit(RouteClass::Bulk,
+                           maxBulkRequests > 0 ? maxBulkRequests : std::max(1, workers / 2));
+        admission.setRetryAfter(RouteClass::Bulk, 5);
+
+        traces.setSampleEvery(static_cast<unsigned>(traceSampleEvery));
+        JsonRequest::CompileSchemas();
         setupRoutes();
     }
 
-    void start()
+    /// Serves every listener from its own thread. When pinning, the thread is bound to
+    /// one CPU before serving, so the event loop threads it spawns inherit that CPU.
+    void start(bool pin = false)
+    {
+        unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < httpEndpoints.size(); ++i)
+        {
+            auto endpoint = httpEndpoints[i];
+            endpoint->setHandler(router.handler());
+            int cpu = pin ? static_cast<int>(i % cpus) : -1;
+            auto serve = [endpoint, cpu]()
+            {
+                if (cpu >= 0)
+                {
+                    PinCurrentThread(cpu);
+                }
+                endpoint->serve();
+            };
+            listenerThreads.emplace_back(serve);
+        }
+        if (uploadEndpoint)
+        {
+            uploadEndpoint->setHandler(uploadRouter.handler());
+            auto endpoint = uploadEndpoint;
+            listenerThreads.emplace_back([endpoint]() { endpoint->serve(); });
+        }
+        LOG_INFO << "Serving " << httpEndpoints.size() << " listener(s)" << (pin ? ", pinned" : "");
+    }
+
+    /// Stops admitting requests and waits for the ones in flight to finish. Returns false
+    /// if some were still running when the timeout expired.
+    bool drain(std::chrono::steady_clock::duration timeout)
     {
-        httpEndpoint->setHandler(router.handler());
-        httpEndpoint->serveThreaded();
+        admission.close();
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (admission.inFlight() > 0)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return true;
     }
 
-    void shutdown() { httpEndpoint->shutdown(); }
+    void shutdown()
+    {
+        for (auto &endpoint : httpEndpoints)
+        {
+            endpoint->shutdown();
+        }
+        if (uploadEndpoint)
+        {
+            uploadEndpoint->shutdown();
+        }
+        for (auto &t : listenerThreads)
+        {
+            t.join();
+        }
+        listenerThreads.clear();
+        workerPool.stop();
+    }
 
 private:
-    void setupRoutes()
+    static void PinCurrentThread(int cpu)
     {
-        using namespace Rest;
-
-        Routes::Get(router, "/instance", Routes::bind(&DDSEndpoint::getInstance, this));
-        Routes::Get(router, "/node/:name", Routes::bind(&DDSEndpoint::getNode, this));
-        Routes::Get(router, "/nodes", Routes::bind(&DDSEndpoint::getNodes, this));
-        Routes::Get(router, "/command/:name",
-                    Routes::bind(&DDSEndpoint::issueCommand, this));
-        Routes::Get(router, "/ready", Routes::bind(&Generic::handleReady));
-        Routes::Get(router, "/debug", Routes::bind(&DDSEndpoint::doDebug, this));
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0)
+        {
+            LOG_WARNING << "Unable to pin listener to CPU " << cpu << ": " << strerror(rc);
+        }
+    }
 
-        Routes::Get(router, "/labs", Routes::bind(&DDSEndpoint::getLabsReport, this));
+    typedef void (DDSEndpoint::*Handler)(const Rest::Request &, Http::ResponseWriter);
 
-        Routes::Get(router, "/events",
-                    Routes::bind(&DDSEndpoint::getEventLog, this));
-        Routes::Get(router, "/events/csv",
-                    Routes::bind(&DDSEndpoint::getEventLogCSV, this));
+    /// Takes an in-flight slot for the route class and enforces the route's body cap.
+    /// On refusal the response is sent here (503 with Retry-After, or 413) and the
+    /// returned ticket is empty.
+    AdmissionControl::Ticket admit(RouteClass routeClass, size_t maxBody,
+                                   const Rest::Request &request, Http::ResponseWriter &response)
+    {
+        if (request.body().size() > maxBody)
+        {
+            response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+            SendResponse(response, Http::Code::Payload_Too_Large, "Request body too large");
+            return AdmissionControl::Ticket();
+        }
 
-        Routes::Get(router, "/logs",
-                    Routes::bind(&DDSEndpoint::getDiagnosticLog, this));
+        AdmissionControl::Ticket ticket = admission.tryAcquire(routeClass);
+        if (!ticket)
+        {
+            response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+            SendBusy(response, admission.retryAfter(routeClass));
+        }
+        return ticket;
+    }
 
-        Routes::Get(router, "/logs/csv",
-                    Routes::bind(&DDSEndpoint::getDiagnosticLogCSV, this));
+    /// Sends a pooled JSON body straight from its buffer, without an intermediate string.
+    static void SendJson(Http::ResponseWriter &response, const PooledBuffer &body)
+    {
+        TraceMark(TraceStage::Serialized);
+        SendResponse(response, Http::Code::Ok, body.data(), body.size(), MIME(Application, Json));
+    }
 
-        Routes::Get(router, "/modules/count",
-                    Routes::bind(&DDSEndpoint::getModuleCount, this));
-        Routes::Get(router, "/modules",
-                    Routes::bind(&DDSEndpoint::getModules, this));
-        Routes::Get(router, "/module/id/:id",
-                    Routes::bind(&DDSEndpoint::getModuleById, this));
-        Routes::Get(router, "/module/guid/:guid",
-                    Routes::bind(&DDSEndpoint::getModuleByGuid, this));
+    static void SendBusy(Http::ResponseWriter &response, int retryAfter)
+    {
+        auto retryHeader = Http::Header::Raw("Retry-After", to_string(retryAfter));
+        response.headers().addRaw(retryHeader);
+        SendResponse(response, Http::Code::Service_Unavailable, "Server busy");
+    }
 
-        Routes::Get(router, "/modules/other",
-                    Routes::bind(&DDSEndpoint::getOtherModules, this));
+    /// True if the caller asked to be answered only once the sample was written (?wait=1).
+    static bool WantsConfirmation(const Rest::Request &request)
+    {
+        auto wait = request.query().get("wait");
+        return wait && *wait != "0";
+    }
+
+    /// Queues a DDS publish and answers the request with the given body. By default the
+    /// response goes out as soon as the publish is queued; with ?wait=1 it is completed
+    /// from the publisher thread once the write has happened.
+    void publishAndRespond(const Rest::Request &request, Http::ResponseWriter response,
+                           PublishQueue::Publish publish, const std::string &body,
+                           const Http::Mime::MediaType &mime = Http::Mime::MediaType())
+    {
+        if (!WantsConfirmation(request))
+        {
+            if (publisher->enqueue(std::move(publish)))
+            {
+                SendResponse(response, Http::Code::Ok, body, mime);
+            }
+            else
+            {
+                SendBusy(response, 1);
+            }
+            return;
+        }
+
+        auto writer = std::make_shared<Http::ResponseWriter>(std::move(response));
+        auto context = RequestContext::Current();
+        auto done = [writer, body, mime, context](bool ok)
+        {
+            RequestContext::Scope scope(context);
+            if (ok)
+            {
+                SendResponse(*writer, Http::Code::Ok, body, mime);
+            }
+            else
+            {
+                SendResponse(*writer, Http::Code::Internal_Server_Error, "{\"message\":\"Publish failed\"}");
+            }
+        };
+        if (!publisher->enqueue(std::move(publish), done))
+        {
+            SendBusy(*writer, 1);
+        }
+    }
+
+    /// Registers a metered route whose handler runs on the event loop thread; only for
+    /// handlers that never block.
+    void serve(Http::Method method, const std::string &path, RouteClass routeClass, Handler handler,
+               size_t maxBody = DefaultMaxBody)
+    {
+        int route = metrics.addRoute(Http::methodString(method), path);
+        auto serveRequest = [this, route, routeClass, handler, maxBody](const Rest::Request request,
+                                                                        Http::ResponseWriter response)
+        {
+            RequestContext::Scope scope(std::make_shared<RequestContext>(metrics, route, &traces));
+            AdmissionControl::Ticket ticket = admit(routeClass, maxBody, request, response);
+            if (ticket)
+            {
+                TraceMark(TraceStage::Admitted);
+                (this->*handler)(request, std::move(response));
+            }
+            return Rest::Route::Result::Ok;
+        };
+        router.addRoute(method, path, serveRequest);
+    }
+
+    /// Registers a metered route whose handler runs on the worker pool instead of the event
+    /// loop thread. The handler completes the response from the worker once its blocking
+    /// work is done; bulk routes are queued behind telemetry and control work. Routes that
+    /// accept more than MaxMainBody are registered on the upload port as well.
+    void offload(Http::Method method, const std::string &path, RouteClass routeClass, Handler handler,
+                 size_t maxBody = DefaultMaxBody)
+    {
+        int route = metrics.addRoute(Http::methodString(method), path);
+        auto offloadRequest = [this, route, routeClass, handler, maxBody](const Rest::Request request,
+                                                                          Http::ResponseWriter response)
+        {
+            auto context = std::make_shared<RequestContext>(metrics, route, &traces);
+            RequestContext::Scope scope(context);
+            auto ticket = std::make_shared<AdmissionControl::Ticket>(admit(routeClass, maxBody, request, response));
+            if (!*ticket)
+            {
+                return Rest::Route::Result::Ok;
+            }
+            TraceMark(TraceStage::Admitted);
+
+            auto writer = std::make_shared<Http::ResponseWriter>(std::move(response));
+            auto task = [this, handler, request, writer, ticket, context]()
+            {
+                RequestContext::Scope workerScope(context);
+                TraceMark(TraceStage::Dequeued);
+                // A handler that fails after answering must not get a second response.
+                try
+                {
+                    (this->*handler)(request, writer->clone());
+                }
+                catch (const std::exception &e)
+                {
+                    LOG_ERROR << "Handler failed: " << e.what();
+                    if (!context->hasResponded())
+                    {
+                        SendResponse(*writer, Http::Code::Internal_Server_Error, e.what());
+                    }
+                }
+                catch (...)
+                {
+                    LOG_ERROR << "Handler failed with an unknown exception";
+                    if (!context->hasResponded())
+                    {
+                        SendResponse(*writer, Http::Code::Internal_Server_Error, "Internal error");
+                    }
+                }
+            };
+            auto priority = routeClass == RouteClass::Bulk ? WorkerPool::Priority::Low
+                                                           : WorkerPool::Priority::High;
+            if (!workerPool.submit(task, priority))
+            {
+                SendResponse(*writer, Http::Code::Service_Unavailable, "Shutting down");
+            }
+            return Rest::Route::Result::Ok;
+        };
+        router.addRoute(method, path, offloadRequest);
+        if (maxBody > MaxMainBody)
+        {
+            uploadRouter.addRoute(method, path, offloadRequest);
+        }
+    }
+
+    void setupRoutes()
+    {
+        using namespace Rest;
+
+        offload(Http::Method::Get, "/instance", RouteClass::Telemetry, &DDSEndpoint::getInstance);
+        serve(Http::Method::Get, "/node/:name", RouteClass::Telemetry, &DDSEndpoint::getNode);
+        serve(Http::Method::Get, "/nodes", RouteClass::Telemetry, &DDSEndpoint::getNodes);
+        serve(Http::Method::Get, "/waveforms", RouteClass::Telemetry, &DDSEndpoint::getWaveforms);
+        serve(Http::Method::Get, "/waveform/:name", RouteClass::Telemetry, &DDSEndpoint::getWaveform);
+        serve(Http::Method::Get, "/command/:name", RouteClass::Control, &DDSEndpoint::issueCommand);
+        Routes::Get(router, "/ready", Routes::bind(&Generic::handleReady));
+        Routes::Get(router, "/debug", Routes::bind(&DDSEndpoint::doDebug, this));
+
+        serve(Http::Method::Get, "/labs", RouteClass::Telemetry, &DDSEndpoint::getLabsReport);
+
+        serve(Http::Method::Get, "/stats/publish", RouteClass::Telemetry, &DDSEndpoint::getPublishStats);
+        serve(Http::Method::Get, "/stats/dds", RouteClass::Telemetry, &DDSEndpoint::getDdsStats);
+        serve(Http::Method::Get, "/stats/nodes", RouteClass::Telemetry, &DDSEndpoint::getNodeStats);
+        serve(Http::Method::Get, "/stats/ingest", RouteClass::Telemetry, &DDSEndpoint::getIngestStats);
+        serve(Http::Method::Get, "/metrics", RouteClass::Telemetry, &DDSEndpoint::getMetrics);
+        serve(Http::Method::Get, "/debug/traces", RouteClass::Telemetry, &DDSEndpoint::getTraces);
+        serve(Http::Method::Get, "/admin/log_level", RouteClass::Control, &DDSEndpoint::getLogLevel);
+        serve(Http::Method::Put, "/admin/log_level", RouteClass::Control, &DDSEndpoint::setLogLevel);
+
+        offload(Http::Method::Get, "/events", RouteClass::Bulk, &DDSEndpoint::getEventLog);
+        offload(Http::Method::Get, "/events/csv", RouteClass::Bulk, &DDSEndpoint::getEventLogCSV);
+
+        offload(Http::Method::Get, "/logs", RouteClass::Bulk, &DDSEndpoint::getDiagnosticLog);
+
+        offload(Http::Method::Get, "/logs/csv", RouteClass::Bulk, &DDSEndpoint::getDiagnosticLogCSV);
+
+        offload(Http::Method::Get, "/modules/count", RouteClass::Telemetry, &DDSEndpoint::getModuleCount);
+        offload(Http::Method::Get, "/modules", RouteClass::Telemetry, &DDSEndpoint::getModules);
+        offload(Http::Method::Get, "/module/id/:id", RouteClass::Telemetry, &DDSEndpoint::getModuleById);
+        offload(Http::Method::Get, "/module/guid/:guid", RouteClass::Telemetry, &DDSEndpoint::getModuleByGuid);
+
+        offload(Http::Method::Get, "/modules/other", RouteClass::Telemetry, &DDSEndpoint::getOtherModules);
 
         Routes::Get(router, "/shutdown",
                     Routes::bind(&DDSEndpoint::doShutdown, this));
 
-        Routes::Get(router, "/actions",
-                    Routes::bind(&DDSEndpoint::getActions, this));
+        offload(Http::Method::Get, "/actions", RouteClass::Bulk, &DDSEndpoint::getActions);
         Routes::Get(router, "/action/:name",
                     Routes::bind(&DDSEndpoint::getAction, this));
         Routes::Post(router, "/action",
@@ -870,47 +741,46 @@ private:
 
         Routes::Get(router, "/assessments",
                     Routes::bind(&DDSEndpoint::getAssessments, this));
-        Routes::Get(router, "/assessment/:name",
-                    Routes::bind(&DDSEndpoint::getAssessment, this));
-        Routes::Post(router, "/assessment/:name",
-                     Routes::bind(&DDSEndpoint::createAssessment, this));
-        Routes::Put(router, "/assessment/:name",
-                    Routes::bind(&DDSEndpoint::createAssessment, this));
+        offload(Http::Method::Get, "/assessment/:name", RouteClass::Bulk, &DDSEndpoint::getAssessment);
+        offload(Http::Method::Post, "/assessment/:name", RouteClass::Bulk, &DDSEndpoint::createAssessment,
+                maxUploadBytes);
+        offload(Http::Method::Put, "/assessment/:name", RouteClass::Bulk, &DDSEndpoint::createAssessment,
+                maxUploadBytes);
         Routes::Delete(router, "/assessment/:name",
                        Routes::bind(&DDSEndpoint::deleteAssessment, this));
 
-        Routes::Post(router, "/execute",
-                     Routes::bind(&DDSEndpoint::executeCommand, this));
+        serve(Http::Method::Post, "/execute", RouteClass::Control, &DDSEndpoint::executeCommand);
         Routes::Options(router, "/execute",
                         Routes::bind(&DDSEndpoint::executeOptions, this));
 
-        Routes::Post(
-            router, "/topic/physiology_modification",
-            Routes::bind(&DDSEndpoint::executePhysiologyModification, this));
-        Routes::Post(router, "/topic/render_modification",
-                     Routes::bind(&DDSEndpoint::executeRenderModification, this));
-        Routes::Post(
-            router, "/topic/performance_assessment",
-            Routes::bind(&DDSEndpoint::executePerformanceAssessment, this));
+        serve(Http::Method::Post, "/batch", RouteClass::Control, &DDSEndpoint::executeBatch, MaxBatchBody);
+        Routes::Options(router, "/batch",
+                        Routes::bind(&DDSEndpoint::executeOptions, this));
+
+        serve(Http::Method::Post, "/topic/physiology_modification", RouteClass::Control,
+              &DDSEndpoint::executePhysiologyModification);
+        serve(Http::Method::Post, "/topic/render_modification", RouteClass::Control,
+              &DDSEndpoint::executeRenderModification);
+        serve(Http::Method::Post, "/topic/performance_assessment", RouteClass::Control,
+              &DDSEndpoint::executePerformanceAssessment);
         Routes::Options(router, "/topic/:mod_type",
                         Routes::bind(&DDSEndpoint::executeOptions, this));
 
-        Routes::Get(router, "/patients",
-                    Routes::bind(&DDSEndpoint::getPatients, this));
+        offload(Http::Method::Get, "/patients", RouteClass::Bulk, &DDSEndpoint::getPatients);
 
-        Routes::Get(router, "/scenarios",
-                    Routes::bind(&DDSEndpoint::getScenarios, this));
+        offload(Http::Method::Get, "/scenarios", RouteClass::Bulk, &DDSEndpoint::getScenarios);
 
-        Routes::Get(router, "/states", Routes::bind(&DDSEndpoint::getStates, this));
-        Routes::Get(router, "/states/:name/delete",
-                    Routes::bind(&DDSEndpoint::deleteState, this));
+        offload(Http::Method::Get, "/states", RouteClass::Bulk, &DDSEndpoint::getStates);
+        offload(Http::Method::Get, "/states/:name", RouteClass::Bulk, &DDSEndpoint::getState);
+        offload(Http::Method::Get, "/states/:name/delete", RouteClass::Bulk, &DDSEndpoint::deleteState);
     }
 
     void getInstance(const Rest::Request &request,
                      Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         std::ifstream t("static/current_scenario.txt");
         std::string scenario((std::istreambuf_iterator<char>(t)),
@@ -925,14 +795,15 @@ private:
         writer.EndObject();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getStates(const Rest::Request &request, Http::ResponseWriter response)
     {
 
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         writer.StartArray();
         if (exists(state_path) && is_directory(state_path))
@@ -959,7 +830,19 @@ private:
         writer.EndArray();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
+    }
+
+    void getState(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        auto name = request.param(":name").as<std::string>();
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        if (!AtomicFile::IsSafeName(name))
+        {
+            SendResponse(response, Http::Code::Not_Found, "File not found");
+            return;
+        }
+        Download::ServeFile(request, response, state_path + name);
     }
 
     void deleteState(const Rest::Request &request,
@@ -976,18 +859,18 @@ private:
             {
                 LOG_INFO << "Deleting " << deletePath;
                 boost::filesystem::remove(deletePath);
-                response.send(Pistache::Http::Code::Ok, "Deleted",
+                SendResponse(response, Pistache::Http::Code::Ok, "Deleted",
                               MIME(Application, Json));
             }
             else
             {
-                response.send(Pistache::Http::Code::Forbidden,
+                SendResponse(response, Pistache::Http::Code::Forbidden,
                               "Unable to delete state file", MIME(Application, Json));
             }
         }
         else
         {
-            response.send(Pistache::Http::Code::Forbidden,
+            SendResponse(response, Pistache::Http::Code::Forbidden,
                           "Can not delete default state file",
                           MIME(Application, Json));
         }
@@ -996,8 +879,9 @@ private:
     void getScenarios(const Rest::Request &request,
                       Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         writer.StartArray();
         if (exists(scenario_path) && is_directory(scenario_path))
@@ -1031,15 +915,15 @@ private:
         writer.EndArray();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Pistache::Http::Code::Ok, s.GetString(),
-                      MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getPatients(const Rest::Request &request,
                      Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         writer.StartArray();
         if (exists(patient_path) && is_directory(patient_path))
@@ -1067,8 +951,7 @@ private:
         writer.EndArray();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Pistache::Http::Code::Ok, s.GetString(),
-                      MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getAssessments(const Rest::Request &request, Http::ResponseWriter response)
@@ -1076,34 +959,9 @@ private:
         LOG_INFO << "Get a list of all assessment CSVs";
     }
 
-    int writeToFile(const string &filename, const string &data)
-    {
-        std::fstream out;
-
-        out.open(filename, std::fstream::in | std::fstream::out | std::fstream::trunc);
-
-        LOG_INFO << "Writing to " << filename;
-
-        // If file does not exist, Create new file
-        if (!out)
-        {
-            LOG_WARNING << "Cannot open file, file does not exist. Creating new file.";
-            out.open(filename);
-        }
-
-        if (out.fail())
-        {
-            LOG_ERROR << "Open failure: " << strerror(errno);
-            return -1;
-        }
-
-        out << data;
-        out.close();
-
-        LOG_INFO << "All done";
-        return 0;
-    }
-
+    /// Stores an uploaded assessment. The body is written in chunks to a temp file that is
+    /// synced and renamed into place, and ASSESSMENT_AVAILABLE is only published once the
+    /// file is durable, so subscribers never fetch a partial upload.
     void createAssessment(const Rest::Request &request,
                           Http::ResponseWriter response)
     {
@@ -1113,20 +971,46 @@ private:
             LOG_INFO << "Name was empty";
             name = "test.csv";
         }
+        if (!AtomicFile::IsSafeName(name))
+        {
+            SendResponse(response, Http::Code::Bad_Request, "Invalid assessment name");
+            return;
+        }
 
         std::string filename = "assessments/" + name;
         LOG_INFO << "Create an assessment from a POST.  Filename is " << filename;
         auto s = std::chrono::steady_clock::now();
-        writeToFile(filename, request.body());
+        const std::string &body = request.body();
+        AtomicFile::Result stored;
+        std::string error;
+        boost::system::error_code ec;
+        create_directories("assessments", ec);
+        if (!AtomicFile::Write(filename, body.data(), body.size(), stored, error))
+        {
+            LOG_ERROR << "Assessment upload failed: " << error;
+            SendResponse(response, Http::Code::Internal_Server_Error, "Could not store assessment");
+            return;
+        }
         auto dt = std::chrono::steady_clock::now() - s;
         LOG_INFO << "File upload processed in: " << std::chrono::duration_cast<std::chrono::microseconds>(dt).count() << endl;
-        response.send(Http::Code::Ok);
 
+        StringBuffer sb;
+        Writer<StringBuffer> writer(sb);
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(name.c_str());
+        writer.Key("size");
+        writer.Uint64(stored.bytes);
+        writer.Key("sha256");
+        writer.String(stored.sha256.c_str());
+        writer.EndObject();
+
+        // The file is durable before anyone is told about it, so if the notification cannot
+        // be queued the client gets 503 with Retry-After and can safely upload again.
         LOG_INFO << "Sending out system message that there's an assessment available.";
         std::string command = "[SYS]ASSESSMENT_AVAILABLE:" + name;
-        AMM::Command cmdInstance;
-        cmdInstance.message(command);
-        mgr->WriteCommand(cmdInstance);
+        publishAndRespond(request, std::move(response), [command]() { SendCommand(command); }, sb.GetString(),
+                          MIME(Application, Json));
     }
 
     void deleteAssessment(const Rest::Request &request,
@@ -1140,13 +1024,20 @@ private:
         std::string name = request.param(":name").as<std::string>();
         std::string fileName = "assessments/" + name;
         LOG_INFO << "Recieved a request to GET an assessment file, so we're serving this up: " << fileName;
-        Http::serveFile(response, fileName.c_str());
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        if (!AtomicFile::IsSafeName(name))
+        {
+            SendResponse(response, Http::Code::Not_Found, "File not found");
+            return;
+        }
+        Download::ServeFile(request, response, fileName);
     }
 
     void getActions(const Rest::Request &request, Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         writer.StartArray();
         if (exists(action_path) && is_directory(action_path))
@@ -1174,121 +1065,169 @@ private:
         writer.EndArray();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Pistache::Http::Code::Ok, s.GetString(),
-                      MIME(Application, Json));
+        SendJson(response, s);
     }
 
-    void executeCommand(const Rest::Request &request,
-                        Http::ResponseWriter response)
+    /// Parses and validates a single-operation body, then publishes it. Malformed bodies
+    /// are answered with 400 before anything is queued.
+    void executeOperation(RequestKind kind, const Rest::Request &request,
+                          Http::ResponseWriter response, const std::string &body)
     {
-        Document document;
-        document.Parse(request.body().c_str());
-        std::string payload = document["payload"].GetString();
-
-        SendCommand(payload);
-
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
         response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
-        response.send(Pistache::Http::Code::Ok,
-                      "{\"message\":\"Command executed\"}");
+
+        OperationFields fields;
+        std::string error;
+        if (!JsonRequest::ParseOperation(request.body(), kind, fields, error))
+        {
+            SendResponse(response, Http::Code::Bad_Request, JsonRequest::ErrorBody(error));
+            return;
+        }
+        TraceMark(TraceStage::Parsed);
+        publishAndRespond(request, std::move(response), BuildPublish(fields), body);
+    }
+
+    void executeCommand(const Rest::Request &request,
+                        Http::ResponseWriter response)
+    {
+        executeOperation(RequestKind::Command, request, std::move(response),
+                         "{\"message\":\"Command executed\"}");
     }
 
     void executePhysiologyModification(const Rest::Request &request,
                                        Http::ResponseWriter response)
     {
-        std::string type, location, practitioner, payload;
-        Document document;
-        document.Parse(request.body().c_str());
-        if (document.HasMember("type"))
-        {
-            type = document["type"].GetString();
-        }
-        if (document.HasMember("location"))
-        {
-            location = document["location"].GetString();
-        }
-        if (document.HasMember("practitioner"))
-        {
-            practitioner = document["practitioner"].GetString();
-        }
-        if (document.HasMember("payload"))
-        {
-            payload = document["payload"].GetString();
-        }
-        AMM::UUID erID = SendEventRecord(location, practitioner, type);
-        SendPhysiologyModification(erID, type, payload);
-        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
-        response.send(Pistache::Http::Code::Ok,
-                      "{\"message\":\"Physiology modification published\"}");
+        executeOperation(RequestKind::PhysiologyModification, request, std::move(response),
+                         "{\"message\":\"Physiology modification published\"}");
     }
 
     void executeRenderModification(const Rest::Request &request,
                                    Http::ResponseWriter response)
     {
-        std::string type, location, practitioner, payload;
-        Document document;
-        document.Parse(request.body().c_str());
-        if (document.HasMember("type"))
-        {
-            type = document["type"].GetString();
-        }
-        if (document.HasMember("location"))
-        {
-            location = document["location"].GetString();
-        }
-        if (document.HasMember("practitioner"))
-        {
-            practitioner = document["practitioner"].GetString();
-        }
-        if (document.HasMember("payload"))
-        {
-            payload = document["payload"].GetString();
-        }
-        AMM::UUID erID = SendEventRecord(location, practitioner, type);
-        SendRenderModification(erID, type, payload);
-        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
-        response.send(Pistache::Http::Code::Ok,
-                      "{\"message\":\"Render modification published\"}");
+        executeOperation(RequestKind::RenderModification, request, std::move(response),
+                         "{\"message\":\"Render modification published\"}");
     }
 
     void executePerformanceAssessment(const Rest::Request &request,
                                       Http::ResponseWriter response)
     {
-        std::string type, location, practitioner, payload, info, step, comment;
-        Document document;
-        document.Parse(request.body().c_str());
-        if (document.HasMember("type"))
+        executeOperation(RequestKind::PerformanceAssessment, request, std::move(response),
+                         "{\"message\":\"Performance assessment published\"}");
+    }
+
+    /// Publishes an array of mixed operations in order and answers with one result per item.
+    /// Malformed items are reported and skipped; the rest are queued as a single unit so they
+    /// reach DDS in request order.
+    void executeBatch(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
+
+        std::string error;
+        const Value *document = JsonRequest::Parse(request.body(), RequestKind::Batch, error);
+        if (document == nullptr)
         {
-            type = document["type"].GetString();
+            SendResponse(response, Http::Code::Bad_Request, JsonRequest::ErrorBody(error));
+            return;
         }
-        if (document.HasMember("location"))
+        TraceMark(TraceStage::Parsed);
+
+        auto errors = std::make_shared<std::vector<std::string>>(document->Size());
+        auto operations = std::make_shared<std::vector<std::pair<SizeType, PublishQueue::Publish>>>();
+        operations->reserve(document->Size());
+        for (SizeType i = 0; i < document->Size(); ++i)
         {
-            location = document["location"].GetString();
+            OperationFields fields;
+            if (JsonRequest::Extract((*document)[i], RequestKind::Batch, fields, (*errors)[i]))
+            {
+                operations->emplace_back(i, BuildPublish(fields));
+            }
         }
-        if (document.HasMember("practitioner"))
+
+        // Filled in on the publisher thread; read only after it is done.
+        auto published = std::make_shared<std::vector<bool>>(document->Size(), false);
+        auto publishAll = [operations, errors, published]()
         {
-            practitioner = document["practitioner"].GetString();
-        }
-        if (document.HasMember("info"))
+            for (auto &op : *operations)
+            {
+                try
+                {
+                    op.second();
+                    (*published)[op.first] = true;
+                }
+                catch (const std::exception &e)
+                {
+                    (*errors)[op.first] = e.what();
+                }
+            }
+        };
+
+        auto resultBody = [errors, published](bool confirmed)
+        {
+            StringBuffer s;
+            Writer<StringBuffer> writer(s);
+            writer.StartObject();
+            writer.Key("results");
+            writer.StartArray();
+            for (size_t i = 0; i < errors->size(); ++i)
+            {
+                writer.StartObject();
+                writer.Key("index");
+                writer.Uint64(i);
+                writer.Key("status");
+                if (!(*errors)[i].empty())
+                {
+                    writer.String("error");
+                    writer.Key("message");
+                    writer.String((*errors)[i].c_str());
+                }
+                else if (!confirmed)
+                {
+                    writer.String("queued");
+                }
+                else
+                {
+                    writer.String((*published)[i] ? "published" : "error");
+                }
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+            return std::string(s.GetString(), s.GetSize());
+        };
+
+        // Built before queueing; the publisher thread may update the results afterwards.
+        std::string queuedBody = resultBody(false);
+        if (operations->empty())
         {
-            info = document["info"].GetString();
+            SendResponse(response, Http::Code::Ok, queuedBody, MIME(Application, Json));
+            return;
         }
-        if (document.HasMember("step"))
+
+        if (!WantsConfirmation(request))
         {
-            step = document["step"].GetString();
+            if (publisher->enqueue(publishAll))
+            {
+                SendResponse(response, Http::Code::Ok, queuedBody, MIME(Application, Json));
+            }
+            else
+            {
+                SendBusy(response, 1);
+            }
+            return;
         }
-        if (document.HasMember("comment"))
+
+        auto writer = std::make_shared<Http::ResponseWriter>(std::move(response));
+        auto context = RequestContext::Current();
+        auto done = [writer, resultBody, context](bool)
         {
-            comment = document["comment"].GetString();
+            RequestContext::Scope scope(context);
+            SendResponse(*writer, Http::Code::Ok, resultBody(true), MIME(Application, Json));
+        };
+        if (!publisher->enqueue(publishAll, done))
+        {
+            SendBusy(*writer, 1);
         }
-        AMM::UUID erID = SendEventRecord(location, practitioner, type);
-        SendPerformanceAssessment(erID, type, info, step, comment);
-        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
-        response.send(Pistache::Http::Code::Ok,
-                      "{\"message\":\"Performance assessment published\"}");
     }
 
     void executeOptions(const Rest::Request &request,
@@ -1296,7 +1235,7 @@ private:
     {
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
         response.headers().add<Http::Header::AccessControlAllowHeaders>("*");
-        response.send(Pistache::Http::Code::Ok, "{\"message\":\"success\"}");
+        SendResponse(response, Pistache::Http::Code::Ok, "{\"message\":\"success\"}");
     }
 
     void createAction(const Rest::Request &request,
@@ -1323,7 +1262,6 @@ private:
                       Http::ResponseWriter response)
     {
         auto name = request.param(":name").as<std::string>();
-        SendCommand(name);
         StringBuffer s;
         Writer<StringBuffer> writer(s);
         writer.StartObject();
@@ -1331,15 +1269,18 @@ private:
         writer.String(name.c_str());
         writer.EndObject();
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString());
+        publishAndRespond(request, std::move(response),
+                          [name]() { SendCommand(name); },
+                          s.GetString());
     }
 
     void getModuleById(const Rest::Request &request,
                        Http::ResponseWriter response)
     {
         auto id = request.param(":id").as<std::string>();
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         db << "SELECT "
               "module_id AS module_id,"
               "module_name AS module_name,"
@@ -1378,15 +1319,16 @@ private:
         };
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getModuleByGuid(const Rest::Request &request,
                          Http::ResponseWriter response)
     {
         auto guid = request.param(":guid").as<std::string>();
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         db << "SELECT "
               "module_id AS module_id,"
               "module_guid as module_guid,"
@@ -1425,14 +1367,15 @@ private:
         };
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getModuleCount(const Rest::Request &request,
                         Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
 
         int totalCount = 0;
         int coreCount = 0;
@@ -1452,13 +1395,14 @@ private:
         writer.EndObject();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getOtherModules(const Rest::Request &request, Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         writer.StartArray();
         db << "SELECT DISTINCT module_name FROM module_capabilities where module_name NOT LIKE 'AMM_%'" >> [&](string module_name)
         {
@@ -1466,13 +1410,14 @@ private:
         };
         writer.EndArray();
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getModules(const Rest::Request &request, Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         writer.StartArray();
         db << "SELECT "
               "module_capabilities.module_id AS module_id,"
@@ -1513,14 +1458,15 @@ private:
         writer.EndArray();
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getEventLog(const Rest::Request &request,
                      Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         writer.StartArray();
         db << "SELECT "
               "module_capabilities.module_id as module_id,"
@@ -1551,48 +1497,31 @@ private:
             writer.String(data.c_str());
             writer.EndObject();
         };
+        TraceMark(TraceStage::Queried);
 
         writer.EndArray();
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getEventLogCSV(const Rest::Request &request,
                         Http::ResponseWriter response)
     {
-        std::ostringstream s;
-        db << "SELECT "
-              "module_capabilities.module_name,"
-              "events.source,"
-              "events.topic,"
-              "events.tick,"
-              "events.timestamp,"
-              "events.data "
-              "FROM "
-              "events "
-              "LEFT JOIN module_capabilities "
-              "ON "
-              "events.source = module_capabilities.module_guid" >>
-            [&](string module_name, string source, string topic, int64_t tick, int64_t timestamp,
-                string data)
-        {
-            std::time_t temp = timestamp;
-            std::tm *t = std::gmtime(&temp);
-            s << std::put_time(t, "%Y-%m-%d %I:%M:%S %p") << "," << module_name << "," << source << "," << topic
-              << "," << data << std::endl;
-        };
+        std::string csv = EventLogCsv(db);
+        TraceMark(TraceStage::Queried);
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
         auto csvHeader = Http::Header::Raw("Content-Disposition", "attachment;filename=amm_timeline_log.csv");
         response.headers().addRaw(csvHeader);
-        response.send(Http::Code::Ok, s.str(), Http::Mime::MediaType::fromString("text/csv"));
+        Download::ServeContent(request, response, csv, Http::Mime::MediaType::fromString("text/csv"));
     }
 
     void getDiagnosticLog(const Rest::Request &request,
                           Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         writer.StartArray();
         db << "SELECT "
               "logs.module_name, "
@@ -1621,98 +1550,603 @@ private:
             writer.String(message.c_str());
             writer.EndObject();
         };
+        TraceMark(TraceStage::Queried);
 
         writer.EndArray();
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
     }
 
     void getDiagnosticLogCSV(const Rest::Request &request,
                              Http::ResponseWriter response)
     {
-        std::ostringstream s;
-        db << "SELECT "
-              "logs.module_name, "
-              "logs.module_guid, "
-              "logs.module_id, "
-              "logs.message,"
-              "logs.log_level,"
-              "logs.timestamp "
-              "FROM "
-              "logs " >>
-            [&](string module_name, string module_guid, string module_id, string message, string log_level,
-                int64_t timestamp)
-        {
-            std::time_t temp = timestamp;
-            std::tm *t = std::gmtime(&temp);
-            s << std::put_time(t, "%Y-%m-%d %I:%M:%S %p") << "," << log_level << "," << module_name << "," << message
-              << std::endl;
-        };
+        std::string csv = DiagnosticLogCsv(db);
+        TraceMark(TraceStage::Queried);
 
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
         auto csvHeader = Http::Header::Raw("Content-Disposition", "attachment;filename=amm_diagnostic_log.csv");
         response.headers().addRaw(csvHeader);
-        response.send(Http::Code::Ok, s.str(), Http::Mime::MediaType::fromString("text/csv"));
+        Download::ServeContent(request, response, csv, Http::Mime::MediaType::fromString("text/csv"));
     }
 
     void getNodes(const Rest::Request &request, Http::ResponseWriter response)
     {
-        StringBuffer s;
-        Writer<StringBuffer> writer(s);
+        ingestFilter.requestedAll();
+        std::shared_ptr<const NodeStore::Snapshot> nodes = nodeStore.snapshot();
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        WriteNodes(writer, *nodes);
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        response.headers().addRaw(Http::Header::Raw("X-AMM-Frame", to_string(nodes->frame)));
+        SendJson(response, s);
+    }
+
+    void getWaveforms(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
         writer.StartArray();
+        for (const WaveformStore::ChannelInfo &channel : waveformStore.channels())
+        {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(channel.name.c_str(), static_cast<SizeType>(channel.name.size()));
+            writer.Key("unit");
+            writer.String(channel.unit.c_str(), static_cast<SizeType>(channel.unit.size()));
+            writer.Key("next");
+            writer.Uint64(channel.samples);
+            writer.Key("rate_hz");
+            writer.Double(channel.rateHz);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        SendJson(response, s);
+    }
 
-        auto nit = nodeDataStorage.begin();
-        while (nit != nodeDataStorage.end())
+    /// Header of a /waveform/<name> response, followed by `count` (min, max) float pairs.
+    /// All fields little-endian.
+    struct WaveformFrameHeader
+    {
+        char magic[4];       ///< "AMWF"
+        uint16_t version;    ///< 1
+        uint16_t flags;      ///< WaveformGap if samples before `first` were lost
+        uint32_t decimation; ///< Raw samples per pair
+        uint32_t count;      ///< Pairs that follow
+        uint64_t first;      ///< Sequence number of the first raw sample covered
+        uint64_t next;       ///< Pass as ?since= to continue after this frame
+    };
+    static_assert(sizeof(WaveformFrameHeader) == 32, "waveform header is part of the wire format");
+
+    static constexpr uint16_t WaveformGap = 1;
+
+    /// Samples returned when the client gives no ?since=.
+    static constexpr uint64_t WaveformDefaultWindow = 2048;
+
+    /// Largest number of (min, max) pairs in one response.
+    static constexpr uint64_t WaveformMaxPairs = 8192;
+
+    /// Recent samples of a waveform channel as a packed binary frame, reduced to min/max
+    /// pairs of ?decimate=n raw samples (default 1). ?since=<next> continues from the
+    /// previous response; a client that fell more than the ring behind gets the oldest
+    /// samples still kept and the gap flag.
+    void getWaveform(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        auto name = request.param(":name").as<std::string>();
+        const WaveformRing *ring = waveformStore.find(name);
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        if (ring == nullptr)
+        {
+            SendResponse(response, Http::Code::Not_Found, "Waveform does not exist");
+            return;
+        }
+
+        uint64_t decimation = 1;
+        auto decimate = request.query().get("decimate");
+        if (decimate)
+        {
+            decimation = std::strtoull(decimate->c_str(), nullptr, 10);
+            if (decimation == 0 || decimation > WaveformRing::Capacity)
+            {
+                SendResponse(response, Http::Code::Bad_Request, "decimate must be between 1 and the ring size");
+                return;
+            }
+        }
+
+        uint64_t head = ring->head();
+        uint64_t since;
+        auto sinceParam = request.query().get("since");
+        if (sinceParam)
         {
+            since = std::min<uint64_t>(std::strtoull(sinceParam->c_str(), nullptr, 10), head);
+        }
+        else
+        {
+            uint64_t window = std::max(WaveformDefaultWindow, decimation);
+            since = head > window ? head - window : 0;
+        }
+
+        thread_local std::vector<float> samples;
+        thread_local std::vector<float> reduced;
+        uint64_t first = ring->read(since, samples);
+        size_t pairs = std::min<uint64_t>(samples.size() / decimation, WaveformMaxPairs);
+        reduced.resize(pairs * 2);
+        DecimateMinMax(samples.data(), pairs * decimation, decimation, reduced.data());
+
+        WaveformFrameHeader header{{'A', 'M', 'W', 'F'}, 1, 0, static_cast<uint32_t>(decimation),
+                                   static_cast<uint32_t>(pairs), first, first + pairs * decimation};
+        if (first > since)
+        {
+            header.flags |= WaveformGap;
+        }
+        std::string body(sizeof(header) + reduced.size() * sizeof(float), '\0');
+        std::memcpy(&body[0], &header, sizeof(header));
+        if (!reduced.empty())
+        {
+            std::memcpy(&body[sizeof(header)], reduced.data(), reduced.size() * sizeof(float));
+        }
+
+        response.headers().addRaw(Http::Header::Raw("X-AMM-Next", to_string(header.next)));
+        SendResponse(response, Http::Code::Ok, body, MIME(Application, OctetStream));
+    }
+
+    void getPublishStats(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        PublishQueue::Stats stats = publisher->stats();
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        writer.StartObject();
+        writer.Key("depth");
+        writer.Uint64(stats.depth);
+        writer.Key("capacity");
+        writer.Uint64(stats.capacity);
+        writer.Key("enqueued");
+        writer.Uint64(stats.enqueued);
+        writer.Key("published");
+        writer.Uint64(stats.published);
+        writer.Key("failed");
+        writer.Uint64(stats.failed);
+        writer.Key("rejected");
+        writer.Uint64(stats.rejected);
+        writer.Key("batches");
+        writer.Uint64(stats.batches);
+        writer.Key("latency_us");
+        writer.StartObject();
+        writer.Key("last");
+        writer.Uint64(stats.lastLatencyUs);
+        writer.Key("mean");
+        writer.Double(stats.meanLatencyUs);
+        writer.Key("max");
+        writer.Uint64(stats.maxLatencyUs);
+        writer.EndObject();
+        writer.EndObject();
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        SendJson(response, s);
+    }
+
+    void getDdsStats(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        DdsStats::TopicSnapshot topics[DdsTopicCount];
+        ddsStats.snapshot(topics);
+
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        writer.StartArray();
+        for (size_t t = 0; t < DdsTopicCount; ++t)
+        {
+            const DdsStats::TopicSnapshot &topic = topics[t];
+            writer.StartObject();
+            writer.Key("topic");
+            writer.String(DdsTopicName(static_cast<DdsTopic>(t)));
+            writer.Key("received");
+            writer.Uint64(topic.received);
+            writer.Key("dropped");
+            writer.Uint64(topic.dropped);
+            writer.Key("rate_hz");
+            writer.Double(topic.rateHz);
+
+            writer.Key("handler_us");
+            writer.StartObject();
+            writer.Key("mean");
+            writer.Double(topic.handlerCount ? topic.handlerSumNs / 1000.0 / topic.handlerCount : 0.0);
+            writer.Key("max");
+            writer.Double(topic.handlerMaxNs / 1000.0);
+            writer.Key("buckets");
+            writer.StartArray();
+            for (size_t i = 0; i <= DdsStats::HandlerBucketCount; ++i)
+            {
+                writer.StartObject();
+                writer.Key("le");
+                if (i < DdsStats::HandlerBucketCount)
+                {
+                    writer.Uint64(DdsStats::HandlerBoundsUs[i]);
+                }
+                else
+                {
+                    writer.String("+Inf");
+                }
+                writer.Key("count");
+                writer.Uint64(topic.handlerBuckets[i]);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+
+            writer.Key("delay_ms");
             writer.StartObject();
-            writer.Key(nit->first.c_str());
-            writer.Double(nit->second);
+            writer.Key("mean");
+            writer.Double(topic.delayCount ? topic.delaySumUs / 1000.0 / topic.delayCount : 0.0);
+            writer.Key("max");
+            writer.Double(topic.delayMaxUs / 1000.0);
+            writer.Key("negative");
+            writer.Uint64(topic.delayNegative);
+            writer.Key("buckets");
+            writer.StartArray();
+            for (size_t i = 0; i <= DdsStats::DelayBucketCount; ++i)
+            {
+                writer.StartObject();
+                writer.Key("le");
+                if (i < DdsStats::DelayBucketCount)
+                {
+                    writer.Uint64(DdsStats::DelayBoundsMs[i]);
+                }
+                else
+                {
+                    writer.String("+Inf");
+                }
+                writer.Key("count");
+                writer.Uint64(topic.delayBuckets[i]);
+                writer.EndObject();
+            }
+            writer.EndArray();
+            writer.EndObject();
+
             writer.EndObject();
-            ++nit;
         }
+        writer.EndArray();
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        SendJson(response, s);
+    }
+
+    /// Per-node ingest stats, busiest first. ?sort=age lists the stalest nodes first and
+    /// ?sort=name alphabetically; ?limit=n keeps only the first n.
+    void getNodeStats(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        using Node = NodeStats::NodeSnapshot;
+        std::vector<Node> nodes = nodeStats.snapshot();
 
-        auto sit = statusStorage.begin();
-        while (sit != statusStorage.end())
+        auto sort = request.query().get("sort");
+        std::string order = sort ? *sort : "rate";
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        if (order == "rate")
+        {
+            std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.rateHz > b.rateHz; });
+        }
+        else if (order == "age")
+        {
+            std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.ageNs > b.ageNs; });
+        }
+        else if (order == "name")
+        {
+            std::sort(nodes.begin(), nodes.end(), [](const Node &a, const Node &b) { return a.name < b.name; });
+        }
+        else
+        {
+            SendResponse(response, Http::Code::Bad_Request, "{\"message\":\"sort must be one of rate, age, name\"}");
+            return;
+        }
+
+        auto limit = request.query().get("limit");
+        if (limit)
+        {
+            long n = std::strtol(limit->c_str(), nullptr, 10);
+            if (n >= 0 && static_cast<std::size_t>(n) < nodes.size())
+            {
+                nodes.resize(static_cast<std::size_t>(n));
+            }
+        }
+
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        writer.StartArray();
+        for (const Node &node : nodes)
         {
             writer.StartObject();
-            writer.Key(sit->first.c_str());
-            writer.String(sit->second.c_str());
+            writer.Key("name");
+            writer.String(node.name.c_str(), static_cast<SizeType>(node.name.size()));
+            writer.Key("samples");
+            writer.Uint64(node.samples);
+            writer.Key("rate_hz");
+            writer.Double(node.rateHz);
+            writer.Key("last_update_ms");
+            writer.Int64(node.lastUpdateNs / 1000000);
+            writer.Key("age_ms");
+            writer.Double(node.ageNs / 1e6);
+            writer.Key("sim_time");
+            writer.Double(node.simTime);
             writer.EndObject();
-            ++sit;
         }
+        writer.EndArray();
+        SendJson(response, s);
+    }
 
+    /// The ingest mode, the node names and prefixes it currently admits, and how many
+    /// values the deadbands held back.
+    void getIngestStats(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        std::vector<std::string> names;
+        std::vector<std::string> prefixes;
+        ingestFilter.allowed(names, prefixes);
+
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        writer.StartObject();
+        writer.Key("mode");
+        writer.String(IngestModeName(ingestFilter.mode()));
+        writer.Key("lease_open");
+        writer.Bool(ingestFilter.leaseOpen());
+        writer.Key("suppressed");
+        writer.Uint64(nodeStore.suppressed());
+        writer.Key("names");
+        writer.StartArray();
+        for (const std::string &name : names)
+        {
+            writer.String(name.c_str(), static_cast<SizeType>(name.size()));
+        }
         writer.EndArray();
+        writer.Key("prefixes");
+        writer.StartArray();
+        for (const std::string &prefix : prefixes)
+        {
+            writer.String(prefix.c_str(), static_cast<SizeType>(prefix.size()));
+        }
+        writer.EndArray();
+        writer.EndObject();
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+        SendJson(response, s);
+    }
+
+    void getLogLevel(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        AsyncLogAppender::Stats stats = logAppender->stats();
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        writer.StartObject();
+        writer.Key("level");
+        writer.String(plog::severityToString(plog::get()->getMaxSeverity()));
+        writer.Key("written");
+        writer.Uint64(stats.written);
+        writer.Key("dropped");
+        writer.Uint64(stats.dropped);
+        writer.Key("queued");
+        writer.Uint64(stats.queued);
+        writer.EndObject();
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        SendJson(response, s);
+    }
+
+    /// Changes the log level at runtime. The level comes from ?level= or the plain body,
+    /// e.g. PUT /admin/log_level?level=debug.
+    void setLogLevel(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        auto query = request.query().get("level");
+        std::string level = query ? *query : request.body();
+        boost::algorithm::trim(level);
+        boost::algorithm::to_upper(level);
+
+        plog::Severity severity = plog::severityFromString(level.c_str());
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        if (severity == plog::none && level != "NONE")
+        {
+            SendResponse(response, Http::Code::Bad_Request,
+                         "{\"message\":\"Level must be one of none, fatal, error, warning, info, debug, verbose\"}");
+            return;
+        }
+        plog::get()->setMaxSeverity(severity);
+        LOG_WARNING << "Log level set to " << plog::severityToString(severity);
+        getLogLevel(request, std::move(response));
+    }
+
+    /// Writes one trace as {"route", "status", "start_us", "total_us", "stages": [...]}.
+    void writeTrace(Writer<StringBuffer> &writer, const TraceRecord &trace)
+    {
+        writer.StartObject();
+        writer.Key("route");
+        writer.String(metrics.routeName(trace.route).c_str());
+        writer.Key("status");
+        writer.Int(trace.status);
+        writer.Key("start_us");
+        writer.Int64(trace.startUs);
+        writer.Key("total_us");
+        writer.Double(trace.totalNs / 1000.0);
+        writer.Key("stages");
+        writer.StartArray();
+        for (uint32_t i = 0; i < trace.markCount; ++i)
+        {
+            writer.StartObject();
+            writer.Key("stage");
+            writer.String(TraceStageName(trace.marks[i].stage));
+            writer.Key("at_us");
+            writer.Double(trace.marks[i].offsetNs / 1000.0);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+    }
+
+    /// Chrome trace-event "complete" events: one span per request, and one per stage
+    /// covering the time since the previous mark. Each request gets its own track.
+    void writeChromeTrace(Writer<StringBuffer> &writer, const TraceRecord &trace, int pid, int tid)
+    {
+        std::string route = metrics.routeName(trace.route);
+        auto event = [&](const char *name, double ts, double dur)
+        {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(name);
+            writer.Key("ph");
+            writer.String("X");
+            writer.Key("ts");
+            writer.Double(ts);
+            writer.Key("dur");
+            writer.Double(dur);
+            writer.Key("pid");
+            writer.Int(pid);
+            writer.Key("tid");
+            writer.Int(tid);
+            writer.EndObject();
+        };
+
+        double start = static_cast<double>(trace.startUs);
+        event(route.c_str(), start, trace.totalNs / 1000.0);
+        uint64_t previous = 0;
+        for (uint32_t i = 0; i < trace.markCount; ++i)
+        {
+            uint64_t at = trace.marks[i].offsetNs;
+            if (trace.marks[i].stage != TraceStage::Routed)
+            {
+                event(TraceStageName(trace.marks[i].stage), start + previous / 1000.0, (at - previous) / 1000.0);
+            }
+            previous = at;
+        }
+    }
+
+    /// Sampled stage traces: the most recent ones and the slowest seen.
+    /// ?format=chrome returns trace-event JSON for chrome://tracing or Perfetto.
+    void getTraces(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        std::vector<TraceRecord> recent;
+        std::vector<TraceRecord> slowest;
+        traces.snapshot(recent, slowest);
+
+        static ResponseSizeHint sizeHint;
+        PooledBuffer s(sizeHint);
+        Writer<StringBuffer> writer(s.buffer());
+        auto format = request.query().get("format");
+        if (format && *format == "chrome")
+        {
+            writer.StartObject();
+            writer.Key("displayTimeUnit");
+            writer.String("ms");
+            writer.Key("traceEvents");
+            writer.StartArray();
+            for (size_t i = 0; i < recent.size(); ++i)
+            {
+                writeChromeTrace(writer, recent[i], 1, static_cast<int>(i) + 1);
+            }
+            for (size_t i = 0; i < slowest.size(); ++i)
+            {
+                writeChromeTrace(writer, slowest[i], 2, static_cast<int>(i) + 1);
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        else
+        {
+            writer.StartObject();
+            writer.Key("sample_every");
+            writer.Int(traceSampleEvery);
+            writer.Key("skipped");
+            writer.Uint64(traces.skipped());
+            writer.Key("recent");
+            writer.StartArray();
+            for (const auto &trace : recent)
+            {
+                writeTrace(writer, trace);
+            }
+            writer.EndArray();
+            writer.Key("slowest");
+            writer.StartArray();
+            for (const auto &trace : slowest)
+            {
+                writeTrace(writer, trace);
+            }
+            writer.EndArray();
+            writer.EndObject();
+        }
+        response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
+        SendJson(response, s);
+    }
+
+    /// Prometheus text exposition of the HTTP, admission and publish queue counters.
+    void getMetrics(const Rest::Request &request, Http::ResponseWriter response)
+    {
+        std::string out;
+        out.reserve(64 * 1024);
+        metrics.render(out);
+
+        out += "# HELP amm_admission_in_flight Admitted requests not yet finished, by route class.\n"
+               "# TYPE amm_admission_in_flight gauge\n";
+        for (size_t c = 0; c < RouteClassCount; ++c)
+        {
+            auto routeClass = static_cast<RouteClass>(c);
+            out += "amm_admission_in_flight{class=\"" + std::string(RouteClassName(routeClass)) + "\"} " +
+                   to_string(admission.inFlight(routeClass)) + "\n";
+        }
+        out += "# HELP amm_admission_rejected_total Requests refused with 503, by route class.\n"
+               "# TYPE amm_admission_rejected_total counter\n";
+        for (size_t c = 0; c < RouteClassCount; ++c)
+        {
+            auto routeClass = static_cast<RouteClass>(c);
+            out += "amm_admission_rejected_total{class=\"" + std::string(RouteClassName(routeClass)) + "\"} " +
+                   to_string(admission.rejected(routeClass)) + "\n";
+        }
+
+        PublishQueue::Stats stats = publisher->stats();
+        out += "# TYPE amm_publish_queue_depth gauge\n"
+               "amm_publish_queue_depth " + to_string(stats.depth) + "\n"
+               "# TYPE amm_publish_published_total counter\n"
+               "amm_publish_published_total " + to_string(stats.published) + "\n"
+               "# TYPE amm_publish_failed_total counter\n"
+               "amm_publish_failed_total " + to_string(stats.failed) + "\n"
+               "# TYPE amm_publish_rejected_total counter\n"
+               "amm_publish_rejected_total " + to_string(stats.rejected) + "\n";
+
+        AsyncLogAppender::Stats logStats = logAppender->stats();
+        out += "# TYPE amm_log_dropped_total counter\n"
+               "amm_log_dropped_total " + to_string(logStats.dropped) + "\n";
+
+        SendResponse(response, Http::Code::Ok, out, Http::Mime::MediaType::fromString("text/plain; version=0.0.4"));
     }
 
     void getLabsReport(const Rest::Request &request, Http::ResponseWriter response)
     {
-        std::string labReport = boost::algorithm::join(labsStorage, "\n");
+        std::string labReport = LabsReport();
         auto mime = Http::Mime::MediaType::fromString("text/csv");
         response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-        response.send(Http::Code::Ok, labReport, mime);
+        Download::ServeContent(request, response, labReport, mime);
     }
 
     void getNode(const Rest::Request &request, Http::ResponseWriter response)
     {
 
         auto name = request.param(":name").as<std::string>();
-        auto it = nodeDataStorage.find(name);
-        if (it != nodeDataStorage.end())
-        {
-            StringBuffer s;
-            Writer<StringBuffer> writer(s);
+        ingestFilter.requested(name);
+        std::shared_ptr<const NodeStore::Snapshot> nodes = nodeStore.snapshot();
+        auto it = nodes->values.find(name);
+        if (it != nodes->values.end())
+        {
+            static ResponseSizeHint sizeHint;
+            PooledBuffer s(sizeHint);
+            Writer<StringBuffer> writer(s.buffer());
             writer.StartObject();
             writer.Key(it->first.c_str());
             writer.Double(it->second);
             writer.EndObject();
             response.headers().add<Http::Header::AccessControlAllowOrigin>("*");
-            response.send(Http::Code::Ok, s.GetString(), MIME(Application, Json));
+            response.headers().addRaw(Http::Header::Raw("X-AMM-Frame", to_string(nodes->frame)));
+            SendJson(response, s);
         }
         else
         {
-            response.send(Http::Code::Not_Found, "Node data does not exist");
+            SendResponse(response, Http::Code::Not_Found, "Node data does not exist");
         }
     }
 
@@ -1720,22 +2154,31 @@ private:
     {
         printCookies(request);
         response.cookies().add(Http::Cookie("lang", "en-US"));
-        response.send(Http::Code::Ok);
+        SendResponse(response, Http::Code::Ok);
     }
 
     void doShutdown(const Rest::Request &request, Http::ResponseWriter response)
     {
-        m_runThread = false;
+        // Handled by the main loop like any other SIGTERM.
+        kill(getpid(), SIGTERM);
         response.cookies().add(Http::Cookie("lang", "en-US"));
-        response.send(Http::Code::Ok);
+        SendResponse(response, Http::Code::Ok);
     }
 
     typedef std::mutex Lock;
     typedef std::lock_guard<Lock> Guard;
     Lock commandLock;
 
-    std::shared_ptr<Http::Endpoint> httpEndpoint;
+    Address address;
+    std::vector<std::shared_ptr<Http::Endpoint>> httpEndpoints;
+    std::shared_ptr<Http::Endpoint> uploadEndpoint;
+    std::vector<std::thread> listenerThreads;
     Rest::Router router;
+    Rest::Router uploadRouter;
+    HttpMetrics metrics;
+    TraceBuffer traces;
+    WorkerPool workerPool;
+    AdmissionControl admission;
 };
 
 static void show_usage(const std::string &name)
@@ -1743,18 +2186,107 @@ static void show_usage(const std::string &name)
     cerr << "Usage: " << name << " <option(s)>"
          << "\nOptions:\n"
          << "\t-h,--help\t\tShow this help message\n"
+         << "\t-threads <n>\t\tEvent loop threads per listener (default 2, 1 when sharded)\n"
+         << "\t-shards <n>\t\tListeners sharing the port via SO_REUSEPORT (0 = one per core)\n"
+         << "\t-pin\t\t\tPin each listener to its own CPU\n"
+         << "\t-workers <n>\t\tWorker threads for blocking requests (default 4)\n"
+         << "\t-max_telemetry <n>\tIn-flight limit for telemetry routes (default 256)\n"
+         << "\t-max_control <n>\tIn-flight limit for command routes (default 64)\n"
+         << "\t-max_bulk <n>\t\tIn-flight limit for exports and uploads (default workers/2)\n"
+         << "\t-max_upload_mb <n>\tLargest accepted assessment upload (default 256)\n"
+         << "\t-upload_port <n>\tPort for large assessment uploads, 0 = none (default 9081)\n"
+         << "\t-publish_queue <n>\tCapacity of the DDS publish queue (default 1024)\n"
+         << "\t-trace_sample <n>\tTrace one in n requests at /debug/traces, 0 = off (default 100)\n"
+         << "\t-logfile <path>\t\tWrite the log to a rotating file instead of the console\n"
+         << "\t-log_level <level>\tInitial log level (default verbose)\n"
+         << "\t-drain_timeout <s>\tSeconds to wait for in-flight requests on shutdown (default 10)\n"
+         << "\t-ingest_config <path>\tIngest configuration (default config/rest_adapter_ingest.xml)\n"
          << endl;
 }
 
+/// Sleeps until SIGINT or SIGTERM arrives or, when stdin is a terminal, EXIT is typed.
+/// The signals must already be blocked in every thread.
+static void WaitForShutdown(const sigset_t &signals)
+{
+    int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+    if (signalFd < 0)
+    {
+        LOG_ERROR << "signalfd failed: " << strerror(errno);
+        int signal = 0;
+        sigwait(&signals, &signal);
+        return;
+    }
+
+    bool interactive = isatty(STDIN_FILENO) == 1;
+    std::string input;
+    bool done = false;
+    while (!done)
+    {
+        pollfd fds[2] = {{signalFd, POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+        if (poll(fds, interactive ? 2 : 1, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR << "poll failed: " << strerror(errno);
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            signalfd_siginfo info;
+            if (read(signalFd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info)))
+            {
+                LOG_INFO << "Received " << strsignal(static_cast<int>(info.ssi_signo)) << ", shutting down.";
+                done = true;
+            }
+        }
+
+        if (interactive && (fds[1].revents & (POLLIN | POLLHUP)))
+        {
+            char buffer[256];
+            ssize_t got = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (got <= 0)
+            {
+                // Terminal went away; keep waiting for signals only.
+                interactive = false;
+                continue;
+            }
+            input.append(buffer, static_cast<size_t>(got));
+            size_t eol;
+            while ((eol = input.find('\n')) != std::string::npos)
+            {
+                std::string action = input.substr(0, eol);
+                input.erase(0, eol + 1);
+                boost::algorithm::trim(action);
+                boost::algorithm::to_upper(action);
+                if (action == "EXIT")
+                {
+                    LOG_INFO << "Shutting down from command-line.";
+                    done = true;
+                }
+            }
+        }
+    }
+    close(signalFd);
+}
+
 Port port(static_cast<uint16_t>(portNumber));
 Address addr(Ipv4::any(), port);
 DDSEndpoint server(addr);
 
 int main(int argc, char *argv[])
 {
-    static plog::ColorConsoleAppender<plog::TxtFormatter> consoleAppender;
-    plog::init(plog::verbose, &consoleAppender);
-
+    // Block the shutdown signals before any thread starts so that every thread inherits
+    // the mask and they are only ever consumed by WaitForShutdown.
+    sigset_t shutdownSignals;
+    sigemptyset(&shutdownSignals);
+    sigaddset(&shutdownSignals, SIGINT);
+    sigaddset(&shutdownSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &shutdownSignals, nullptr);
+
+    bool threadsGiven = false;
     for (int i = 1; i < argc; ++i)
     {
         std::string arg = argv[i];
@@ -1773,18 +2305,108 @@ int main(int argc, char *argv[])
         {
             discovery = 0;
         }
+
+        if (arg == "-threads" && i + 1 < argc)
+        {
+            thr = std::max(1, atoi(argv[++i]));
+            threadsGiven = true;
+        }
+
+        if (arg == "-shards" && i + 1 < argc)
+        {
+            listenerShards = std::max(0, atoi(argv[++i]));
+        }
+
+        if (arg == "-pin")
+        {
+            pinListeners = true;
+        }
+
+        if (arg == "-workers" && i + 1 < argc)
+        {
+            workerThreads = std::max(1, atoi(argv[++i]));
+        }
+
+        if (arg == "-max_telemetry" && i + 1 < argc)
+        {
+            maxTelemetryRequests = atoi(argv[++i]);
+        }
+
+        if (arg == "-max_control" && i + 1 < argc)
+        {
+            maxControlRequests = atoi(argv[++i]);
+        }
+
+        if (arg == "-max_bulk" && i + 1 < argc)
+        {
+            maxBulkRequests = atoi(argv[++i]);
+        }
+
+        if (arg == "-publish_queue" && i + 1 < argc)
+        {
+            publishQueueCapacity = std::max(1, atoi(argv[++i]));
+        }
+
+        if (arg == "-max_upload_mb" && i + 1 < argc)
+        {
+            maxUploadBytes = static_cast<size_t>(std::max(1, atoi(argv[++i]))) * 1024 * 1024;
+        }
+
+        if (arg == "-upload_port" && i + 1 < argc)
+        {
+            uploadPortNumber = std::max(0, atoi(argv[++i]));
+        }
+
+        if (arg == "-trace_sample" && i + 1 < argc)
+        {
+            traceSampleEvery = std::max(0, atoi(argv[++i]));
+        }
+
+        if (arg == "-logfile" && i + 1 < argc)
+        {
+            logFile = argv[++i];
+        }
+
+        if (arg == "-log_level" && i + 1 < argc)
+        {
+            logLevel = argv[++i];
+            boost::algorithm::to_upper(logLevel);
+        }
+
+        if (arg == "-drain_timeout" && i + 1 < argc)
+        {
+            drainSeconds = std::max(0, atoi(argv[++i]));
+        }
+
+        if (arg == "-ingest_config" && i + 1 < argc)
+        {
+            ingestConfigFile = argv[++i];
+        }
     }
 
-    string action;
+    static AsyncLogAppender asyncAppender(logFile);
+    logAppender = &asyncAppender;
+    logAppender->start();
+    plog::Severity severity = plog::severityFromString(logLevel.c_str());
+    plog::init(severity == plog::none && logLevel != "NONE" ? plog::verbose : severity, logAppender);
 
     ResetLabs();
+    ingestFilter.load(ingestConfigFile);
+    Deadbands deadbands;
+    if (deadbands.load(ingestConfigFile))
+    {
+        nodeStore.setDeadbands(deadbands);
+    }
+    statusMap.load(ingestConfigFile);
 
     RESTListener al;
+    al.setResetHandler(SendReset);
     mgr = new AMM::DDSManager<RESTListener>(configFile);
 
     mgr->InitializeCommand();
     mgr->InitializeSimulationControl();
     mgr->InitializePhysiologyValue();
+    mgr->InitializePhysiologyWaveform();
     mgr->InitializeTick();
     mgr->InitializeEventRecord();
     mgr->InitializeRenderModification();
@@ -1797,6 +2419,7 @@ int main(int argc, char *argv[])
 
     mgr->CreateTickSubscriber(&al, &RESTListener::onNewTick);
     mgr->CreatePhysiologyValueSubscriber(&al, &RESTListener::onNewPhysiologyValue);
+    mgr->CreatePhysiologyWaveformSubscriber(&al, &RESTListener::onNewPhysiologyWaveform);
     mgr->CreateCommandSubscriber(&al, &RESTListener::onNewCommand);
     mgr->CreateStatusSubscriber(&al, &RESTListener::onNewStatus);
     mgr->CreateRenderModificationSubscriber(&al, &RESTListener::onNewRenderModification);
@@ -1815,37 +2438,45 @@ int main(int argc, char *argv[])
 
     m_uuid.id(mgr->GenerateUuidString());
 
+    publisher = new PublishQueue(static_cast<size_t>(publishQueueCapacity));
+    publisher->start();
+
     std::this_thread::sleep_for(std::chrono::milliseconds(250));
 
     PublishOperationalDescription();
 
     gethostname(hostname, HOST_NAME_MAX);
 
-    server.init(thr);
-    LOG_INFO << "Listening on *:" << portNumber;
+    if (listenerShards != 1 && !threadsGiven)
+    {
+        // One event loop per shard; the shards themselves provide the parallelism.
+        thr = 1;
+    }
 
-    m_runThread = true;
+    server.init(thr, workerThreads, listenerShards);
+    LOG_INFO << "Listening on *:" << portNumber;
+    if (uploadPortNumber > 0)
+    {
+        LOG_INFO << "Accepting uploads on *:" << uploadPortNumber;
+    }
 
-    server.start();
+    server.start(pinListeners);
 
     LOG_INFO << "Ready.";
 
-    while (m_runThread)
+    WaitForShutdown(shutdownSignals);
+
+    // New requests get 503 while the admitted ones finish. Queued publishes are flushed
+    // before the listeners close so that ?wait responses still reach their clients.
+    if (!server.drain(std::chrono::seconds(drainSeconds)))
     {
-        getline(cin, action);
-        transform(action.begin(), action.end(), action.begin(), ::toupper);
-        if (action == "EXIT")
-        {
-            m_runThread = false;
-            LOG_INFO << "Shutting down from command-line.";
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(250));
-        cout.flush();
+        LOG_WARNING << "Drain timed out with requests still in flight";
     }
-
+    publisher->stop();
     server.shutdown();
 
     LOG_INFO << "Shutdown complete";
+    logAppender->stop();
 
     return 0;
 }
@@ -0,0 +1,338 @@
+#include "RESTListener.h"
+
+#include <cmath>
+#include <string_view>
+
+#include "amm/BaseLogger.h"
+#include "amm/Utility.h"
+
+#include "NodeData.h"
+
+const std::string sysPrefix = "[SYS]";
+const std::string actPrefix = "[ACT]";
+const std::string loadScenarioPrefix = "LOAD_SCENARIO:";
+const std::string loadPrefix = "LOAD_STATE:";
+const std::string loadPatientPrefix = "LOAD_PATIENT:";
+
+DdsStats ddsStats;
+NodeStats nodeStats;
+IngestFilter ingestFilter;
+WaveformStore waveformStore;
+StatusMap statusMap;
+
+namespace
+{
+    /// FNV-1a. Usable in case labels, so two render types that hash alike fail to compile.
+    constexpr uint32_t Fnv1a(std::string_view text)
+    {
+        uint32_t hash = 2166136261u;
+        for (char c : text)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    /// Monitor leads, as bits; their status slots are in MonitorSlots.
+    enum Monitor : unsigned
+    {
+        MonitorEcg = 1 << 0,
+        MonitorPulseOx = 1 << 1,
+        MonitorNibp = 1 << 2,
+        MonitorTemp = 1 << 3,
+        MonitorArtLine = 1 << 4,
+        MonitorEtco2 = 1 << 5,
+        MonitorAll = (1 << 6) - 1,
+    };
+
+    const std::string MonitorSlots[] = {"MONITOR_ECG",  "MONITOR_PULSEOX", "MONITOR_NIBP",
+                                        "MONITOR_TEMP", "MONITOR_ARTLINE", "MONITOR_ETCO2"};
+
+    struct MonitorChange
+    {
+        const char *type;  ///< The matched type, to rule out a hash collision with any other
+        unsigned monitors; ///< Monitor bits to switch; 0 for types that change none
+        bool connected;
+    };
+
+    /// The monitor leads a render modification connects or detaches.
+    MonitorChange MonitorChangeFor(std::string_view type)
+    {
+        switch (Fnv1a(type))
+        {
+        case Fnv1a("CONNECT_ECG"):
+            return {"CONNECT_ECG", MonitorEcg, true};
+        case Fnv1a("DETACH_ECG"):
+            return {"DETACH_ECG", MonitorEcg, false};
+        case Fnv1a("CONNECT_PULSE_OX"):
+            return {"CONNECT_PULSE_OX", MonitorPulseOx, true};
+        case Fnv1a("DETACH_PULSE_OX"):
+            return {"DETACH_PULSE_OX", MonitorPulseOx, false};
+        case Fnv1a("CONNECT_NIBP"):
+            return {"CONNECT_NIBP", MonitorNibp, true};
+        case Fnv1a("DETACH_NIBP"):
+            return {"DETACH_NIBP", MonitorNibp, false};
+        case Fnv1a("CONNECT_TEMP_PROBE"):
+            return {"CONNECT_TEMP_PROBE", MonitorTemp, true};
+        case Fnv1a("DETACH_TEMP_PROBE"):
+            return {"DETACH_TEMP_PROBE", MonitorTemp, false};
+        case Fnv1a("CONNECT_ART_LINE"):
+            return {"CONNECT_ART_LINE", MonitorArtLine, true};
+        case Fnv1a("DETACH_ART_LINE"):
+            return {"DETACH_ART_LINE", MonitorArtLine, false};
+        case Fnv1a("CONNECT_ETCO2"):
+            return {"CONNECT_ETCO2", MonitorEtco2, true};
+        case Fnv1a("DETACH_ETCO2"):
+            return {"DETACH_ETCO2", MonitorEtco2, false};
+        case Fnv1a("ATTACH_TO_PATIENT"):
+            return {"ATTACH_TO_PATIENT", MonitorAll, true};
+        case Fnv1a("DETACH_FROM_PATIENT"):
+            return {"DETACH_FROM_PATIENT", MonitorAll, false};
+        default:
+            return {"", 0, false};
+        }
+    }
+}
+
+std::string ExtractTypeFromRenderMod(std::string payload)
+{
+    std::size_t pos = payload.find("type=");
+    if (pos != std::string::npos)
+    {
+        std::string p1 = payload.substr(pos + 6);
+        std::size_t pos2 = p1.find("\"");
+        if (pos2 != std::string::npos)
+        {
+            std::string p2 = p1.substr(0, pos2);
+            return p2;
+        }
+    }
+    return {};
+};
+
+std::string ExtractManikinIDFromString(std::string in)
+{
+    std::size_t pos = in.find("mid=");
+    if (pos != std::string::npos)
+    {
+        std::string mid1 = in.substr(pos + 4);
+        std::size_t pos1 = mid1.find(";");
+        if (pos1 != std::string::npos)
+        {
+            std::string mid2 = mid1.substr(0, pos1);
+            return mid2;
+        }
+        return mid1;
+    }
+    return {};
+}
+
+int64_t SourceTimeNs(const eprosima::fastrtps::SampleInfo_t *info)
+{
+    if (info == nullptr)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>(info->sourceTimestamp.seconds()) * 1000000000 + info->sourceTimestamp.nanosec();
+}
+
+void RESTListener::onNewStatus(AMM::Status &st, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::Status, SourceTimeNs(info));
+    // Status names are short enough for the small-string buffer: no allocation.
+    std::string statusValue = AMM::Utility::EStatusValueStr(st.value());
+
+    LOG_DEBUG << "[" << st.module_id().id() << "][" << st.module_name() << "]["
+              << st.capability() << "] Status = " << statusValue << " (" << st.value() << ")";
+    // Message = " << st.message();
+
+    const StatusRoute *route = statusMap.find(st.module_name(), st.capability());
+    if (route == nullptr)
+    {
+        return;
+    }
+    statusStorage[route->slot] = statusValue;
+    if (!route->node.empty())
+    {
+        // The message carries the reading, e.g. psi of the air supply or % battery charge.
+        double reading;
+        if (StatusMap::ParseReading(st.message(), reading))
+        {
+            nodeStore.setNow(route->node, reading);
+        }
+    }
+}
+
+void RESTListener::onNewTick(AMM::Tick &t, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::Tick, SourceTimeNs(info));
+    if (statusStorage["STATUS"].compare("NOT RUNNING") == 0 &&
+        t.frame() > lastTick)
+    {
+        statusStorage["STATUS"] = "RUNNING";
+    }
+    lastTick = t.frame();
+    // The frame has advanced: publish the values staged since the previous tick.
+    nodeStore.commit(t.frame(), t.time());
+    nodeStats.setSimTime(t.time());
+    statusStorage["TICK"] = std::to_string(t.frame());
+    statusStorage["TIME"] = std::to_string(t.time());
+}
+
+void RESTListener::onNewSimulationControl(AMM::SimulationControl &simControl, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::SimulationControl, SourceTimeNs(info));
+    switch (simControl.type())
+    {
+    case AMM::ControlType::RUN:
+    {
+        statusStorage["STATUS"] = "RUNNING";
+        LOG_DEBUG << "SimControl received: Run sim.";
+        break;
+    }
+
+    case AMM::ControlType::HALT:
+    {
+        statusStorage["STATUS"] = "PAUSED";
+        break;
+    }
+
+    case AMM::ControlType::RESET:
+    {
+        LOG_DEBUG
+            << "SimControl received: Reset simulation, clean up and prepare for next run.";
+        statusStorage["STATUS"] = "NOT RUNNING";
+        statusStorage["TICK"] = "0";
+        statusStorage["TIME"] = "0";
+        nodeStore.clear();
+        ResetLabs();
+        break;
+    }
+    }
+}
+
+void RESTListener::onNewCommand(AMM::Command &c, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::Command, SourceTimeNs(info));
+    std::string manikin_id = ExtractManikinIDFromString(c.message());
+    LOG_INFO << "Got a command: " << c.message() << " for manikin " << manikin_id;
+    if (!c.message().compare(0, sysPrefix.size(), sysPrefix))
+    {
+        std::string value = c.message().substr(sysPrefix.size());
+        if (value.find("START_SIM") != std::string::npos)
+        {
+            statusStorage["STATUS"] = "RUNNING";
+        }
+        else if (value.find("STOP_SIM") != std::string::npos)
+        {
+            statusStorage["STATUS"] = "STOPPED";
+        }
+        else if (value.find("PAUSE_SIM") != std::string::npos)
+        {
+            statusStorage["STATUS"] = "PAUSED";
+        }
+        else if (value.find("RESET_SIM") != std::string::npos)
+        {
+            statusStorage["STATUS"] = "NOT RUNNING";
+            statusStorage["TICK"] = "0";
+            statusStorage["TIME"] = "0";
+            nodeStore.clear();
+            ResetLabs();
+        }
+        else if (value.find("END_SIMULATION") != std::string::npos)
+        {
+            statusStorage["STATUS"] = "STOPPED";
+            statusStorage["TICK"] = "0";
+            statusStorage["TIME"] = "0";
+            nodeStore.clear();
+            ResetLabs();
+        }
+        else if (value.find("APPEND_LABS") != std::string::npos)
+        {
+            AppendLabRow();
+        }
+        else if (value.find("CLEAR_LOG") != std::string::npos)
+        {
+        }
+        else if (value.find("RESTART_SERVICE") != std::string::npos)
+        {
+            LOG_INFO << "Command: RESTART_SERVICE" << c.message();
+        }
+        else if (!value.compare(0, loadPrefix.size(), loadPrefix))
+        {
+            statusStorage["STATE"] = value.substr(loadPrefix.size());
+            if (m_resetHandler)
+            {
+                m_resetHandler();
+            }
+        }
+        else if (!value.compare(0, loadScenarioPrefix.size(),
+                                loadScenarioPrefix))
+        {
+            statusStorage["SCENARIO"] = value.substr(loadScenarioPrefix.size());
+        }
+        else if (!value.compare(0, loadPatientPrefix.size(),
+                                loadPatientPrefix))
+        {
+            statusStorage["PATIENT"] = value.substr(loadPatientPrefix.size());
+        }
+    }
+    else
+    {
+        // LOG_TRACE << "Unknown AMM Command: " << c.message();
+    }
+}
+
+void RESTListener::onNewPhysiologyValue(AMM::PhysiologyValue &n, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::PhysiologyValue, SourceTimeNs(info));
+    //      LOG_TRACE << "Getting physiology value: " << n.name() << " = " << n.value();
+    if (!ingestFilter.accepts(n.name()))
+    {
+        probe.dropped();
+        return;
+    }
+    nodeStats.record(n.name());
+    if (!std::isnan(n.value()))
+    {
+        nodeStore.set(n.name(), n.value());
+    }
+    else
+    {
+        probe.dropped();
+    }
+}
+
+void RESTListener::onNewPhysiologyWaveform(AMM::PhysiologyWaveform &w, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::PhysiologyWaveform, SourceTimeNs(info));
+    if (!std::isnan(w.value()))
+    {
+        waveformStore.push(w.name(), w.unit(), static_cast<float>(w.value()));
+    }
+    else
+    {
+        probe.dropped();
+    }
+}
+
+void RESTListener::onNewRenderModification(AMM::RenderModification &rendMod, SampleInfo_t *info)
+{
+    DdsStats::Probe probe(ddsStats, DdsTopic::RenderModification, SourceTimeNs(info));
+    // LOG_DEBUG << "Render modification received from AMM: type=" << rendMod.type() << ";payload=" << rendMod.data();
+
+    std::string_view type = rendMod.type();
+    MonitorChange change = MonitorChangeFor(type);
+    if (change.monitors == 0 || type != change.type)
+    {
+        return;
+    }
+    for (std::size_t i = 0; i < sizeof(MonitorSlots) / sizeof(MonitorSlots[0]); ++i)
+    {
+        if (change.monitors & (1u << i))
+        {
+            statusStorage[MonitorSlots[i]] = change.connected ? "ON" : "OFF";
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "amm_std.h"
+
+#include "DdsStats.h"
+#include "IngestFilter.h"
+#include "NodeStats.h"
+#include "StatusMap.h"
+#include "WaveformStore.h"
+
+extern const std::string sysPrefix;
+extern const std::string actPrefix;
+extern const std::string loadScenarioPrefix;
+extern const std::string loadPrefix;
+extern const std::string loadPatientPrefix;
+
+/// Per-topic profile of the listener callbacks, served at /stats/dds.
+extern DdsStats ddsStats;
+
+/// Per-node sample counts, rates and last update times, served at /stats/nodes.
+extern NodeStats nodeStats;
+
+/// Physiology nodes the listener stores; the rest are dropped on arrival.
+extern IngestFilter ingestFilter;
+
+/// Recent waveform samples by channel, served at /waveform/<name>.
+extern WaveformStore waveformStore;
+
+/// Where module Status samples are stored.
+extern StatusMap statusMap;
+
+std::string ExtractTypeFromRenderMod(std::string payload);
+std::string ExtractManikinIDFromString(std::string in);
+
+/// Source timestamp of a sample in nanoseconds since the epoch, or 0 if unknown.
+int64_t SourceTimeNs(const eprosima::fastrtps::SampleInfo_t *info);
+
+/// Core logic container for DDS Manager functions.
+class RESTListener : public AMM::ListenerInterface
+{
+public:
+    using SampleInfo_t = eprosima::fastrtps::SampleInfo_t;
+
+    /// Called when a LOAD_STATE command asks for the simulation to be reset.
+    void setResetHandler(std::function<void()> handler) { m_resetHandler = std::move(handler); }
+
+    void onNewStatus(AMM::Status &st, SampleInfo_t *info);
+    void onNewTick(AMM::Tick &t, SampleInfo_t *info);
+    void onNewSimulationControl(AMM::SimulationControl &simControl, SampleInfo_t *info);
+    void onNewCommand(AMM::Command &c, SampleInfo_t *info);
+    void onNewPhysiologyValue(AMM::PhysiologyValue &n, SampleInfo_t *info);
+    void onNewPhysiologyWaveform(AMM::PhysiologyWaveform &w, SampleInfo_t *info);
+    void onNewRenderModification(AMM::RenderModification &rendMod, SampleInfo_t *info);
+
+private:
+    std::function<void()> m_resetHandler;
+};
@@ -0,0 +1,134 @@
+#include "RequestContext.h"
+
+#include <algorithm>
+
+using namespace Pistache;
+
+namespace
+{
+    std::shared_ptr<RequestContext> &CurrentSlot()
+    {
+        thread_local std::shared_ptr<RequestContext> current;
+        return current;
+    }
+
+    /// Keeps a traced context alive until the transport has written the response.
+    void TraceWrite(Async::Promise<ssize_t> &&sent)
+    {
+        std::shared_ptr<RequestContext> context = RequestContext::Current();
+        if (!context || !context->traced())
+        {
+            return;
+        }
+        sent.then([context](ssize_t) { context->mark(TraceStage::Written); }, Async::IgnoreException);
+    }
+}
+
+RequestContext::RequestContext(HttpMetrics &metrics, int route, TraceBuffer *traces)
+    : m_metrics(metrics), m_route(route), m_start(std::chrono::steady_clock::now())
+{
+    m_metrics.recordStart(m_route);
+    if (traces != nullptr && traces->shouldSample())
+    {
+        m_traces = traces;
+        m_trace.reset(new TraceRecord());
+        m_trace->route = route;
+        m_trace->startUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                               std::chrono::system_clock::now().time_since_epoch())
+                               .count();
+        mark(TraceStage::Routed);
+    }
+}
+
+RequestContext::~RequestContext()
+{
+    responded(0, 0);
+    if (m_trace)
+    {
+        m_trace->markCount = std::min<uint32_t>(m_markCount.load(std::memory_order_relaxed), TraceRecord::MaxMarks);
+        m_trace->totalNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+        m_traces->record(*m_trace);
+    }
+}
+
+void RequestContext::responded(int status, std::size_t bytes)
+{
+    if (m_responded.exchange(true, std::memory_order_relaxed))
+    {
+        return;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - m_start;
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    m_metrics.recordResponse(m_route, status, bytes, ns);
+    if (m_trace)
+    {
+        m_trace->status = status;
+        mark(TraceStage::Responded);
+    }
+}
+
+void RequestContext::mark(TraceStage stage)
+{
+    if (!m_trace)
+    {
+        return;
+    }
+    // Marks can come from the worker and the event loop at once; each claims its own slot.
+    uint32_t index = m_markCount.fetch_add(1, std::memory_order_relaxed);
+    if (index < TraceRecord::MaxMarks)
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_trace->marks[index].stage = stage;
+        m_trace->marks[index].offsetNs =
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+}
+
+const std::shared_ptr<RequestContext> &RequestContext::Current()
+{
+    return CurrentSlot();
+}
+
+RequestContext::Scope::Scope(std::shared_ptr<RequestContext> context)
+    : m_previous(std::move(CurrentSlot()))
+{
+    CurrentSlot() = std::move(context);
+}
+
+RequestContext::Scope::~Scope()
+{
+    CurrentSlot() = std::move(m_previous);
+}
+
+void RecordResponse(Http::Code code, std::size_t bytes)
+{
+    const auto &context = RequestContext::Current();
+    if (context)
+    {
+        context->responded(static_cast<int>(code), bytes);
+    }
+}
+
+void TraceMark(TraceStage stage)
+{
+    const auto &context = RequestContext::Current();
+    if (context)
+    {
+        context->mark(stage);
+    }
+}
+
+void SendResponse(Http::ResponseWriter &response, Http::Code code, const std::string &body,
+                  const Http::Mime::MediaType &mime)
+{
+    RecordResponse(code, body.size());
+    TraceWrite(response.send(code, body, mime));
+}
+
+void SendResponse(Http::ResponseWriter &response, Http::Code code, const char *data, std::size_t size,
+                  const Http::Mime::MediaType &mime)
+{
+    RecordResponse(code, size);
+    TraceWrite(response.send(code, data, size, mime));
+}
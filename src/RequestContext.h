@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <pistache/http.h>
+
+#include "HttpMetrics.h"
+#include "TraceBuffer.h"
+
+/// State of one metered request. A request can be answered from the event loop thread,
+/// a worker or the publisher thread, so the context is shared and made current on
+/// whichever thread is working on it; SendResponse records on the current context.
+/// Sampled requests also collect stage timestamps, recorded into the trace buffer when the
+/// context is released after the response was written.
+class RequestContext
+{
+public:
+    RequestContext(HttpMetrics &metrics, int route, TraceBuffer *traces = nullptr);
+
+    /// Counts a request that was never answered, so in-flight gauges do not leak, and
+    /// records the trace of a sampled request.
+    ~RequestContext();
+
+    RequestContext(const RequestContext &) = delete;
+    RequestContext &operator=(const RequestContext &) = delete;
+
+    /// Records the response; only the first call counts.
+    void responded(int status, std::size_t bytes);
+
+    /// True once a response has been recorded.
+    bool hasResponded() const { return m_responded.load(std::memory_order_relaxed); }
+
+    bool traced() const { return m_trace != nullptr; }
+
+    /// Timestamps a stage of a sampled request; a no-op otherwise.
+    void mark(TraceStage stage);
+
+    /// The context of the request the calling thread is working on, if any.
+    static const std::shared_ptr<RequestContext> &Current();
+
+    /// Makes a context current on this thread for the lifetime of the scope.
+    class Scope
+    {
+    public:
+        explicit Scope(std::shared_ptr<RequestContext> context);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        std::shared_ptr<RequestContext> m_previous;
+    };
+
+private:
+    HttpMetrics &m_metrics;
+    int m_route;
+    std::chrono::steady_clock::time_point m_start;
+    std::atomic<bool> m_responded{false};
+
+    TraceBuffer *m_traces = nullptr;
+    std::unique_ptr<TraceRecord> m_trace;
+    std::atomic<uint32_t> m_markCount{0};
+};
+
+/// Marks a stage on the current request context, if it is traced.
+void TraceMark(TraceStage stage);
+
+/// Records status and body size on the current request context.
+void RecordResponse(Pistache::Http::Code code, std::size_t bytes);
+
+/// ResponseWriter::send, metered. All responses of metered routes go through these.
+void SendResponse(Pistache::Http::ResponseWriter &response, Pistache::Http::Code code, const std::string &body = "",
+                  const Pistache::Http::Mime::MediaType &mime = Pistache::Http::Mime::MediaType());
+void SendResponse(Pistache::Http::ResponseWriter &response, Pistache::Http::Code code, const char *data,
+                  std::size_t size, const Pistache::Http::Mime::MediaType &mime);
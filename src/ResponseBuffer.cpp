@@ -0,0 +1,55 @@
+#include "ResponseBuffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+    /// Buffers that grew past this are released instead of pooled, so one huge export
+    /// does not pin its memory to a thread forever.
+    static constexpr std::size_t MaxPooledCapacity = 4 * 1024 * 1024;
+
+    /// Free buffers of the calling thread.
+    std::vector<std::unique_ptr<rapidjson::StringBuffer>> &FreeList()
+    {
+        thread_local std::vector<std::unique_ptr<rapidjson::StringBuffer>> freeList;
+        return freeList;
+    }
+}
+
+void ResponseSizeHint::record(std::size_t bytes)
+{
+    std::size_t current = m_bytes.load(std::memory_order_relaxed);
+    std::size_t next = bytes >= current ? bytes : current - (current - bytes) / 8;
+    m_bytes.store(next, std::memory_order_relaxed);
+}
+
+PooledBuffer::PooledBuffer(ResponseSizeHint &hint) : m_hint(hint)
+{
+    auto &freeList = FreeList();
+    if (freeList.empty())
+    {
+        m_buffer = new rapidjson::StringBuffer();
+    }
+    else
+    {
+        m_buffer = freeList.back().release();
+        freeList.pop_back();
+    }
+    m_buffer->Clear();
+    m_buffer->Reserve(hint.get());
+}
+
+PooledBuffer::~PooledBuffer()
+{
+    std::size_t used = m_buffer->GetSize();
+    m_hint.record(used);
+
+    if (used > MaxPooledCapacity)
+    {
+        delete m_buffer;
+        return;
+    }
+    m_buffer->Clear();
+    FreeList().emplace_back(m_buffer);
+}
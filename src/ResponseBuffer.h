@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+#include "rapidjson/stringbuffer.h"
+
+/// Learned response size of one route, used to size buffers before serializing.
+/// Grows immediately to a larger response and decays slowly after smaller ones.
+class ResponseSizeHint
+{
+public:
+    std::size_t get() const { return m_bytes.load(std::memory_order_relaxed); }
+    void record(std::size_t bytes);
+
+private:
+    std::atomic<std::size_t> m_bytes{256};
+};
+
+/// A StringBuffer borrowed from the calling thread's pool for the duration of one response.
+/// Buffers keep their capacity between requests, so steady-state serialization does not
+/// allocate; the buffer is returned to the pool and the route's hint updated on destruction.
+class PooledBuffer
+{
+public:
+    explicit PooledBuffer(ResponseSizeHint &hint);
+    ~PooledBuffer();
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    rapidjson::StringBuffer &buffer() { return *m_buffer; }
+    const char *data() const { return m_buffer->GetString(); }
+    std::size_t size() const { return m_buffer->GetSize(); }
+
+private:
+    ResponseSizeHint &m_hint;
+    rapidjson::StringBuffer *m_buffer;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Incremental SHA-256 (FIPS 180-4), used to report content hashes of uploads.
+class Sha256
+{
+public:
+    Sha256();
+
+    void update(const void *data, std::size_t size);
+
+    /// Finishes the hash and returns it as 64 lowercase hex characters.
+    std::string hexDigest();
+
+private:
+    void transform(const uint8_t *block);
+
+    uint32_t m_state[8];
+    uint8_t m_block[64];
+    std::size_t m_blockSize = 0;
+    uint64_t m_totalBytes = 0;
+};
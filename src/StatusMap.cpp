@@ -0,0 +1,121 @@
+#include "StatusMap.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+
+#include "tinyxml2.h"
+
+#include "amm/BaseLogger.h"
+
+StatusMap::StatusMap()
+{
+    add({"AMM_FluidManager", "fluidics", "FLUIDICS_STATE", ""});
+    add({"AMM_FluidManager", "clear_supply", "CLEAR_SUPPLY", ""});
+    add({"AMM_FluidManager", "blood_supply", "BLOOD_SUPPLY", ""});
+    add({"AMM_FluidManager", "air_supply", "AIR_SUPPLY", "Air_Pressure"});
+    add({"Torso_Control", "fluidics", "FLUIDICS_STATE", ""});
+    add({"Torso_Control", "clear_supply", "CLEAR_SUPPLY", ""});
+    add({"Torso_Control", "blood_supply", "BLOOD_SUPPLY", ""});
+    add({"Torso_Control", "air_supply", "AIR_SUPPLY", "Air_Pressure"});
+    add({"AJAMS_Services", "battery-1", "BATTERY1", "Battery1_SOC"});
+    add({"AJAMS_Services", "battery-2", "BATTERY2", "Battery2_SOC"});
+    add({"AJAMS_Services", "ext_power", "EXT_POWER", ""});
+    add({"", "iv_detection", "IVARM_STATE", ""});
+}
+
+bool StatusMap::load(const std::string &path)
+{
+    tinyxml2::XMLDocument doc;
+    if (doc.LoadFile(path.c_str()) != tinyxml2::XML_SUCCESS)
+    {
+        return false;
+    }
+
+    const tinyxml2::XMLElement *map = doc.FirstChildElement();
+    if (map != nullptr && std::strcmp(map->Name(), "StatusMap") != 0)
+    {
+        map = map->FirstChildElement("StatusMap");
+    }
+    if (map == nullptr)
+    {
+        return false;
+    }
+
+    clear();
+    std::size_t count = 0;
+    for (const tinyxml2::XMLElement *status = map->FirstChildElement("Status"); status != nullptr;
+         status = status->NextSiblingElement("Status"))
+    {
+        const char *capability = status->Attribute("capability");
+        const char *slot = status->Attribute("slot");
+        if (capability == nullptr || slot == nullptr)
+        {
+            LOG_WARNING << "Ignoring <Status> without capability and slot in " << path;
+            continue;
+        }
+        const char *module = status->Attribute("module");
+        const char *node = status->Attribute("node");
+        add({module ? module : "", capability, slot, node ? node : ""});
+        ++count;
+    }
+    LOG_INFO << "Status map: " << count << " route(s)";
+    return true;
+}
+
+void StatusMap::clear()
+{
+    m_routes.clear();
+}
+
+void StatusMap::add(const StatusRoute &route)
+{
+    m_routes[route.capability].push_back(route);
+}
+
+const StatusRoute *StatusMap::find(const std::string &module, const std::string &capability) const
+{
+    auto it = m_routes.find(capability);
+    if (it == m_routes.end())
+    {
+        return nullptr;
+    }
+    const StatusRoute *any = nullptr;
+    for (const StatusRoute &route : it->second)
+    {
+        if (route.module == module)
+        {
+            return &route;
+        }
+        if (route.module.empty() && any == nullptr)
+        {
+            any = &route;
+        }
+    }
+    return any;
+}
+
+bool StatusMap::ParseReading(const std::string &message, double &value)
+{
+    const char *begin = message.data();
+    const char *end = begin + message.size();
+    while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+    {
+        ++begin;
+    }
+    if (begin != end && *begin == '+')
+    {
+        ++begin;
+    }
+
+    auto result = std::from_chars(begin, end, value);
+    if (result.ec == std::errc::result_out_of_range)
+    {
+        return false;
+    }
+    if (result.ec != std::errc())
+    {
+        value = 0.0;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Where a module's Status sample goes: the status slot that receives its value (e.g.
+/// AIR_SUPPLY), and optionally a node that receives the number in its message (e.g.
+/// Air_Pressure from "14.7").
+struct StatusRoute
+{
+    /// Publishing module; empty matches any module.
+    std::string module;
+    std::string capability;
+    std::string slot;
+    /// Empty if the message carries no reading.
+    std::string node;
+};
+
+/// Dispatch table from (module_name, capability) to status routes, built once at startup.
+/// The default table covers the fluid manager, torso, AJAMS and IV arm; the <StatusMap>
+/// element of the ingest configuration replaces it:
+///
+///   <StatusMap>
+///      <Status module="AMM_FluidManager" capability="air_supply" slot="AIR_SUPPLY" node="Air_Pressure"/>
+///      <Status capability="iv_detection" slot="IVARM_STATE"/>
+///   </StatusMap>
+class StatusMap
+{
+public:
+    StatusMap();
+
+    /// Returns false, keeping the current table, if the file has no <StatusMap> element.
+    bool load(const std::string &path);
+
+    void clear();
+    void add(const StatusRoute &route);
+
+    /// The route for a sample, or nullptr. A route for the module beats one for any module.
+    /// Does not allocate.
+    const StatusRoute *find(const std::string &module, const std::string &capability) const;
+
+    /// Reads the leading number of a status message as std::stod would: leading spaces
+    /// are skipped and trailing text ignored. Returns false if the number is out of range;
+    /// a message without a number reads as 0.
+    static bool ParseReading(const std::string &message, double &value);
+
+private:
+    /// Routes by capability; each list is short, so the module is matched linearly.
+    std::unordered_map<std::string, std::vector<StatusRoute>> m_routes;
+};
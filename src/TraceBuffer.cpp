@@ -0,0 +1,111 @@
+#include "TraceBuffer.h"
+
+#include <algorithm>
+
+const char *TraceStageName(TraceStage stage)
+{
+    switch (stage)
+    {
+    case TraceStage::Routed:
+        return "routed";
+    case TraceStage::Admitted:
+        return "admitted";
+    case TraceStage::Dequeued:
+        return "dequeued";
+    case TraceStage::Parsed:
+        return "parsed";
+    case TraceStage::Queried:
+        return "queried";
+    case TraceStage::Serialized:
+        return "serialized";
+    case TraceStage::Responded:
+        return "responded";
+    case TraceStage::Written:
+        return "written";
+    }
+    return "unknown";
+}
+
+TraceBuffer::TraceBuffer(std::size_t capacity, std::size_t slowestCount)
+    : m_slots(new Slot[capacity]), m_capacity(capacity), m_slowestCount(slowestCount)
+{
+    m_slowest.reserve(slowestCount + 1);
+}
+
+bool TraceBuffer::shouldSample()
+{
+    unsigned every = m_sampleEvery.load(std::memory_order_relaxed);
+    if (every == 0)
+    {
+        return false;
+    }
+    thread_local unsigned counter = 0;
+    return ++counter % every == 0;
+}
+
+void TraceBuffer::record(const TraceRecord &trace)
+{
+    uint64_t sequence = m_head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[sequence % m_capacity];
+    uint32_t idle = 0;
+    if (slot.state.compare_exchange_strong(idle, 1, std::memory_order_acquire))
+    {
+        slot.trace = trace;
+        slot.sequence = sequence;
+        slot.used = true;
+        slot.state.store(0, std::memory_order_release);
+    }
+    else
+    {
+        m_skipped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (trace.totalNs <= m_slowestFloorNs.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_slowestMutex);
+    auto slower = [](const TraceRecord &a, const TraceRecord &b) { return a.totalNs > b.totalNs; };
+    m_slowest.insert(std::upper_bound(m_slowest.begin(), m_slowest.end(), trace, slower), trace);
+    if (m_slowest.size() > m_slowestCount)
+    {
+        m_slowest.pop_back();
+    }
+    if (m_slowest.size() == m_slowestCount)
+    {
+        m_slowestFloorNs.store(m_slowest.back().totalNs, std::memory_order_relaxed);
+    }
+}
+
+void TraceBuffer::snapshot(std::vector<TraceRecord> &recent, std::vector<TraceRecord> &slowest) const
+{
+    std::vector<std::pair<uint64_t, TraceRecord>> copied;
+    copied.reserve(m_capacity);
+    for (std::size_t i = 0; i < m_capacity; ++i)
+    {
+        Slot &slot = m_slots[i];
+        uint32_t idle = 0;
+        if (!slot.state.compare_exchange_strong(idle, 2, std::memory_order_acquire))
+        {
+            continue;
+        }
+        if (slot.used)
+        {
+            copied.emplace_back(slot.sequence, slot.trace);
+        }
+        slot.state.store(0, std::memory_order_release);
+    }
+    std::sort(copied.begin(), copied.end(),
+              [](const std::pair<uint64_t, TraceRecord> &a, const std::pair<uint64_t, TraceRecord> &b)
+              { return a.first < b.first; });
+
+    recent.clear();
+    recent.reserve(copied.size());
+    for (auto &entry : copied)
+    {
+        recent.push_back(entry.second);
+    }
+
+    std::lock_guard<std::mutex> lock(m_slowestMutex);
+    slowest = m_slowest;
+}
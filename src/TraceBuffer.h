@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// Points in a request's life recorded on sampled requests.
+enum class TraceStage : uint8_t
+{
+    Routed,     ///< Router matched the route (trace start).
+    Admitted,   ///< Admission control granted a slot.
+    Dequeued,   ///< A worker picked up an offloaded request.
+    Parsed,     ///< Request body parsed and validated.
+    Queried,    ///< SQLite query finished.
+    Serialized, ///< Response body built.
+    Responded,  ///< Response handed to the transport.
+    Written,    ///< Transport finished writing the response.
+};
+
+const char *TraceStageName(TraceStage stage);
+
+/// Stage timings of one sampled request.
+struct TraceRecord
+{
+    static constexpr std::size_t MaxMarks = 12;
+
+    struct Mark
+    {
+        TraceStage stage;
+        uint64_t offsetNs; ///< Since the Routed mark.
+    };
+
+    int route = -1;
+    int status = 0;
+    int64_t startUs = 0; ///< Wall clock, microseconds since the epoch.
+    uint64_t totalNs = 0;
+    uint32_t markCount = 0;
+    Mark marks[MaxMarks];
+};
+
+/// Recent sampled requests in a fixed ring, plus the slowest ones seen.
+/// Recording never blocks: writers claim a ring slot with one atomic increment and skip
+/// the record if a reader is copying that slot. Only a new entry into the slowest set
+/// takes a mutex, and the fast path rejects most records before that.
+class TraceBuffer
+{
+public:
+    explicit TraceBuffer(std::size_t capacity = 256, std::size_t slowestCount = 16);
+
+    TraceBuffer(const TraceBuffer &) = delete;
+    TraceBuffer &operator=(const TraceBuffer &) = delete;
+
+    /// Trace one in every n requests; 0 disables tracing.
+    void setSampleEvery(unsigned n) { m_sampleEvery.store(n, std::memory_order_relaxed); }
+
+    /// Decides whether the calling thread's next request is traced.
+    bool shouldSample();
+
+    void record(const TraceRecord &trace);
+
+    /// Copies the ring (oldest first) and the slowest records (slowest first).
+    void snapshot(std::vector<TraceRecord> &recent, std::vector<TraceRecord> &slowest) const;
+
+    uint64_t skipped() const { return m_skipped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot
+    {
+        /// 0 = idle, 1 = being written, 2 = being read.
+        std::atomic<uint32_t> state{0};
+        bool used = false;
+        uint64_t sequence = 0;
+        TraceRecord trace;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_capacity;
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<unsigned> m_sampleEvery{0};
+    std::atomic<uint64_t> m_skipped{0};
+
+    std::size_t m_slowestCount;
+    mutable std::mutex m_slowestMutex;
+    std::vector<TraceRecord> m_slowest;
+    std::atomic<uint64_t> m_slowestFloorNs{0};
+};
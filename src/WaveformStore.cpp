@@ -0,0 +1,191 @@
+#include "WaveformStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    int64_t SteadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void MinMaxScalar(const float *samples, std::size_t count, float &min, float &max)
+    {
+        min = samples[0];
+        max = samples[0];
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            min = std::min(min, samples[i]);
+            max = std::max(max, samples[i]);
+        }
+    }
+
+#if defined(__SSE2__)
+    /// Four lanes at a time, folded at the end; the tail that does not fill a vector is
+    /// done in scalar code.
+    void MinMaxSse2(const float *samples, std::size_t count, float &min, float &max)
+    {
+        __m128 vmin = _mm_loadu_ps(samples);
+        __m128 vmax = vmin;
+        std::size_t i = 4;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 v = _mm_loadu_ps(samples + i);
+            vmin = _mm_min_ps(vmin, v);
+            vmax = _mm_max_ps(vmax, v);
+        }
+        vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmin = _mm_min_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmax = _mm_max_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+        min = _mm_cvtss_f32(vmin);
+        max = _mm_cvtss_f32(vmax);
+        for (; i < count; ++i)
+        {
+            min = std::min(min, samples[i]);
+            max = std::max(max, samples[i]);
+        }
+    }
+#endif
+}
+
+WaveformRing::WaveformRing() : m_samples(new std::atomic<float>[Capacity])
+{
+    for (std::size_t i = 0; i < Capacity; ++i)
+    {
+        m_samples[i].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+void WaveformRing::push(float value)
+{
+    uint64_t seq = m_head.load(std::memory_order_relaxed);
+    // Announce the overwrite before doing it: a reader that sees the new value also sees
+    // the claim and discards the slot.
+    m_claimed.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_samples[seq % Capacity].store(value, std::memory_order_relaxed);
+    m_head.store(seq + 1, std::memory_order_release);
+
+    if ((seq + 1) % RateWindow == 0)
+    {
+        int64_t now = SteadyNowNs();
+        if (m_windowStartNs > 0 && now > m_windowStartNs)
+        {
+            m_rateHz.store(RateWindow * 1e9 / static_cast<double>(now - m_windowStartNs), std::memory_order_relaxed);
+        }
+        m_windowStartNs = now;
+    }
+}
+
+uint64_t WaveformRing::read(uint64_t from, std::vector<float> &out) const
+{
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    uint64_t oldest = head > Capacity ? head - Capacity : 0;
+    from = std::min(std::max(from, oldest), head);
+
+    out.resize(static_cast<std::size_t>(head - from));
+    for (uint64_t seq = from; seq < head; ++seq)
+    {
+        out[static_cast<std::size_t>(seq - from)] = m_samples[seq % Capacity].load(std::memory_order_relaxed);
+    }
+
+    // Slots the writer claimed while we copied may hold newer samples; drop them.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+    uint64_t valid = claimed > Capacity ? claimed - Capacity : 0;
+    if (valid > from)
+    {
+        std::size_t lost = static_cast<std::size_t>(std::min(valid, head) - from);
+        out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(lost));
+        from += lost;
+    }
+    return from;
+}
+
+uint64_t WaveformRing::head() const
+{
+    return m_head.load(std::memory_order_acquire);
+}
+
+double WaveformRing::rateHz() const
+{
+    return m_rateHz.load(std::memory_order_relaxed);
+}
+
+void WaveformStore::push(const std::string &name, const std::string &unit, float value)
+{
+    Channel *channel = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_channels.find(name);
+        if (it != m_channels.end())
+        {
+            channel = it->second.get();
+        }
+    }
+    if (channel == nullptr)
+    {
+        // Channels are never removed, so the pointer stays valid once the lock is released.
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        std::unique_ptr<Channel> &slot = m_channels[name];
+        if (!slot)
+        {
+            slot.reset(new Channel);
+            slot->unit = unit;
+        }
+        channel = slot.get();
+    }
+    channel->ring.push(value);
+}
+
+const WaveformRing *WaveformStore::find(const std::string &name) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto it = m_channels.find(name);
+    return it != m_channels.end() ? &it->second->ring : nullptr;
+}
+
+std::vector<WaveformStore::ChannelInfo> WaveformStore::channels() const
+{
+    std::vector<ChannelInfo> channels;
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    channels.reserve(m_channels.size());
+    for (const auto &entry : m_channels)
+    {
+        channels.push_back({entry.first, entry.second->unit, entry.second->ring.head(), entry.second->ring.rateHz()});
+    }
+    std::sort(channels.begin(), channels.end(),
+              [](const ChannelInfo &a, const ChannelInfo &b) { return a.name < b.name; });
+    return channels;
+}
+
+std::size_t DecimateMinMax(const float *samples, std::size_t count, std::size_t factor, float *out)
+{
+    if (factor == 0)
+    {
+        return 0;
+    }
+    std::size_t buckets = count / factor;
+    for (std::size_t b = 0; b < buckets; ++b)
+    {
+        const float *bucket = samples + b * factor;
+#if defined(__SSE2__)
+        if (factor >= 8)
+        {
+            MinMaxSse2(bucket, factor, out[2 * b], out[2 * b + 1]);
+            continue;
+        }
+#endif
+        MinMaxScalar(bucket, factor, out[2 * b], out[2 * b + 1]);
+    }
+    return buckets;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Recent samples of one waveform channel (ECG lead, pleth, ...). One thread writes, the
+/// DDS waveform listener; any number of HTTP handlers read without locking. Every sample
+/// has a sequence number, so a client can resume from where its last read ended.
+class WaveformRing
+{
+public:
+    /// Samples kept per channel: about 30 s at 500 Hz.
+    static constexpr std::size_t Capacity = 16384;
+
+    WaveformRing();
+
+    /// Appends a sample. Only one thread may push.
+    void push(float value);
+
+    /// Copies the samples from sequence number `from` up to the newest into out, skipping
+    /// any that were already overwritten. Returns the sequence number of out[0].
+    uint64_t read(uint64_t from, std::vector<float> &out) const;
+
+    /// Sequence number the next sample will get, i.e. the samples pushed so far.
+    uint64_t head() const;
+
+    /// Sample rate measured over the last RateWindow samples.
+    double rateHz() const;
+
+private:
+    static constexpr uint64_t RateWindow = 256;
+
+    std::unique_ptr<std::atomic<float>[]> m_samples;
+    /// Sequence number being written; samples older than claimed - Capacity are gone.
+    std::atomic<uint64_t> m_claimed{0};
+    std::atomic<uint64_t> m_head{0};
+
+    int64_t m_windowStartNs = 0;
+    std::atomic<double> m_rateHz{0.0};
+};
+
+/// Waveform channels by name, created on their first sample.
+class WaveformStore
+{
+public:
+    struct ChannelInfo
+    {
+        std::string name;
+        std::string unit;
+        uint64_t samples;
+        double rateHz;
+    };
+
+    /// Appends a sample to the channel, creating it if needed. Called from the one DDS
+    /// thread that delivers waveforms.
+    void push(const std::string &name, const std::string &unit, float value);
+
+    /// The channel's ring, or nullptr if it has never received a sample.
+    const WaveformRing *find(const std::string &name) const;
+
+    std::vector<ChannelInfo> channels() const;
+
+private:
+    struct Channel
+    {
+        std::string unit;
+        WaveformRing ring;
+    };
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Channel>> m_channels;
+};
+
+/// Reduces samples to one (min, max) pair per `factor` consecutive samples, so that
+/// peaks such as QRS complexes survive decimation. Only whole buckets are reduced; the
+/// return value is the number of pairs written to out, which needs room for
+/// 2 * (count / factor) floats.
+std::size_t DecimateMinMax(const float *samples, std::size_t count, std::size_t factor, float *out);
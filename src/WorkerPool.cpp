@@ -0,0 +1,107 @@
+#include "WorkerPool.h"
+
+#include <exception>
+
+#include "amm/BaseLogger.h"
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::start(std::size_t threads)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+    {
+        return;
+    }
+    m_running = true;
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+        {
+            return;
+        }
+        m_running = false;
+    }
+    m_cond.notify_all();
+    for (auto &t : m_threads)
+    {
+        t.join();
+    }
+    m_threads.clear();
+}
+
+bool WorkerPool::submit(Task task, Priority priority)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running)
+        {
+            return false;
+        }
+        if (priority == Priority::High)
+        {
+            m_high.push_back(std::move(task));
+        }
+        else
+        {
+            m_low.push_back(std::move(task));
+        }
+    }
+    m_cond.notify_one();
+    return true;
+}
+
+std::size_t WorkerPool::pending() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_high.size() + m_low.size();
+}
+
+void WorkerPool::run()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]
+                        { return !m_running || !m_high.empty() || !m_low.empty(); });
+            std::deque<Task> &queue = m_high.empty() ? m_low : m_high;
+            if (queue.empty())
+            {
+                // Only reached once stopped and fully drained.
+                return;
+            }
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Worker task failed: " << e.what();
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Worker task failed with an unknown exception";
+        }
+    }
+}
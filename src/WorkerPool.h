@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Fixed-size pool of threads for work that may block (disk, SQLite, child processes),
+/// so that the HTTP event loop threads only multiplex I/O.
+class WorkerPool
+{
+public:
+    typedef std::function<void()> Task;
+
+    /// High priority tasks are always dequeued before low priority ones.
+    enum class Priority
+    {
+        High,
+        Low,
+    };
+
+    WorkerPool() = default;
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /// Spawns the given number of worker threads (at least one).
+    void start(std::size_t threads);
+
+    /// Finishes all queued tasks and joins the worker threads.
+    void stop();
+
+    /// Queues a task; returns false if the pool is not running.
+    bool submit(Task task, Priority priority = Priority::High);
+
+    std::size_t size() const { return m_threads.size(); }
+
+    std::size_t pending() const;
+
+private:
+    void run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Task> m_high;
+    std::deque<Task> m_low;
+    std::vector<std::thread> m_threads;
+    bool m_running = false;
+};
@@ -0,0 +1,291 @@
+/// amm_dds_generator: publishes engine-like PhysiologyValue, Tick, Status and
+/// RenderModification traffic so the adapter can be benchmarked without Pulse or modules.
+///
+/// By default samples go out on DDS through DDSManager, exactly as the engine publishes
+/// them. With -mock they are handed straight to a RESTListener in this process instead,
+/// which stress-tests the ingest path without Fast-RTPS.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "amm_std.h"
+
+#include "DdsStats.h"
+#include "NodeData.h"
+#include "RESTListener.h"
+#include "TrafficGenerator.h"
+
+namespace
+{
+    std::atomic<bool> stopRequested{false};
+
+    void OnSignal(int)
+    {
+        stopRequested.store(true);
+    }
+
+    /// The generator only publishes.
+    class GeneratorListener : public AMM::ListenerInterface
+    {
+    };
+
+    class DdsSink : public TrafficSink
+    {
+    public:
+        DdsSink(AMM::DDSManager<GeneratorListener> &mgr, const AMM::UUID &id) : m_mgr(mgr), m_id(id) {}
+
+        void tick(AMM::Tick &tick) override { m_mgr.WriteTick(tick); }
+        void physiologyValue(AMM::PhysiologyValue &value) override { m_mgr.WritePhysiologyValue(value); }
+        void physiologyWaveform(AMM::PhysiologyWaveform &sample) override { m_mgr.WritePhysiologyWaveform(sample); }
+
+        void status(AMM::Status &status) override
+        {
+            status.module_id(m_id);
+            m_mgr.WriteStatus(status);
+        }
+
+        void renderModification(AMM::RenderModification &mod) override { m_mgr.WriteRenderModification(mod); }
+
+    private:
+        AMM::DDSManager<GeneratorListener> &m_mgr;
+        AMM::UUID m_id;
+    };
+
+    /// Calls the adapter's listener directly, as the DDS subscriber threads would.
+    class ListenerSink : public TrafficSink
+    {
+    public:
+        explicit ListenerSink(RESTListener &listener) : m_listener(listener) {}
+
+        void tick(AMM::Tick &tick) override { m_listener.onNewTick(tick, nullptr); }
+        void physiologyValue(AMM::PhysiologyValue &value) override { m_listener.onNewPhysiologyValue(value, nullptr); }
+
+        void physiologyWaveform(AMM::PhysiologyWaveform &sample) override
+        {
+            m_listener.onNewPhysiologyWaveform(sample, nullptr);
+        }
+        void status(AMM::Status &status) override { m_listener.onNewStatus(status, nullptr); }
+
+        void renderModification(AMM::RenderModification &mod) override
+        {
+            m_listener.onNewRenderModification(mod, nullptr);
+        }
+
+    private:
+        RESTListener &m_listener;
+    };
+
+    void ShowUsage(const std::string &name)
+    {
+        std::cerr << "Usage: " << name << " <option(s)>"
+                  << "\nOptions:\n"
+                  << "\t-config <path>\t\tDDS configuration (default config/rest_adapter_amm.xml)\n"
+                  << "\t-nodes <n>\t\tPhysiology values per tick (default 200)\n"
+                  << "\t-tick_hz <n>\t\tTicks per second, 0 = as fast as possible (default 50)\n"
+                  << "\t-status_every <n>\tTicks between status samples, 0 = none (default 50)\n"
+                  << "\t-render_every <n>\tTicks between render modifications, 0 = none (default 250)\n"
+                  << "\t-burst <every>:<rounds>\tEvery n ticks republish all nodes <rounds> times\n"
+                  << "\t-waveforms <n>\t\tWaveform channels (default 0)\n"
+                  << "\t-waveform_samples <n>\tSamples per channel per tick (default 10)\n"
+                  << "\t-duration <s>\t\tRun time (default 30)\n"
+                  << "\t-threads <n>\t\tGenerators running in parallel; all but the first publish\n"
+                  << "\t\t\t\tonly physiology values (default 1)\n"
+                  << "\t-mock\t\t\tCall the REST listener in process instead of publishing\n"
+                  << std::endl;
+    }
+
+    void PrintListenerStats()
+    {
+        DdsStats::TopicSnapshot topics[DdsTopicCount];
+        ddsStats.snapshot(topics);
+        std::printf("\n%-20s %12s %10s %12s %12s\n", "Topic", "received", "dropped", "mean (us)", "max (us)");
+        for (std::size_t i = 0; i < DdsTopicCount; ++i)
+        {
+            const DdsStats::TopicSnapshot &t = topics[i];
+            if (t.received == 0)
+            {
+                continue;
+            }
+            double mean = t.handlerCount > 0 ? static_cast<double>(t.handlerSumNs) / t.handlerCount / 1000.0 : 0.0;
+            std::printf("%-20s %12llu %10llu %12.3f %12.3f\n", DdsTopicName(static_cast<DdsTopic>(i)),
+                        static_cast<unsigned long long>(t.received), static_cast<unsigned long long>(t.dropped),
+                        mean, static_cast<double>(t.handlerMaxNs) / 1000.0);
+        }
+        std::shared_ptr<const NodeStore::Snapshot> nodes = nodeStore.snapshot();
+        std::printf("\nNodes published: %zu at frame %lld\n", nodes->values.size(),
+                    static_cast<long long>(nodes->frame));
+        for (const WaveformStore::ChannelInfo &channel : waveformStore.channels())
+        {
+            std::printf("Waveform %-20s %10llu samples %8.1f Hz\n", channel.name.c_str(),
+                        static_cast<unsigned long long>(channel.samples), channel.rateHz);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    TrafficOptions options;
+    std::string configFile = "config/rest_adapter_amm.xml";
+    int threads = 1;
+    bool mock = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help")
+        {
+            ShowUsage(argv[0]);
+            return 0;
+        }
+        else if (arg == "-config" && hasValue)
+        {
+            configFile = argv[++i];
+        }
+        else if (arg == "-nodes" && hasValue)
+        {
+            options.nodes = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-tick_hz" && hasValue)
+        {
+            options.tickHz = std::max(0.0, std::atof(argv[++i]));
+        }
+        else if (arg == "-status_every" && hasValue)
+        {
+            options.statusEvery = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-render_every" && hasValue)
+        {
+            options.renderEvery = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-burst" && hasValue)
+        {
+            std::string burst = argv[++i];
+            std::size_t colon = burst.find(':');
+            options.burstEvery = std::max(0, std::atoi(burst.c_str()));
+            if (colon != std::string::npos)
+            {
+                options.burstRounds = std::max(1, std::atoi(burst.c_str() + colon + 1));
+            }
+        }
+        else if (arg == "-waveforms" && hasValue)
+        {
+            options.waveforms = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-waveform_samples" && hasValue)
+        {
+            options.waveformSamples = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-duration" && hasValue)
+        {
+            options.duration = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-threads" && hasValue)
+        {
+            threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-mock")
+        {
+            mock = true;
+        }
+        else
+        {
+            ShowUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+
+    RESTListener listener;
+    std::unique_ptr<AMM::DDSManager<GeneratorListener>> mgr;
+    std::unique_ptr<TrafficSink> sink;
+    if (mock)
+    {
+        ResetLabs();
+        sink.reset(new ListenerSink(listener));
+    }
+    else
+    {
+        mgr.reset(new AMM::DDSManager<GeneratorListener>(configFile));
+        mgr->InitializeTick();
+        mgr->InitializePhysiologyValue();
+        mgr->InitializePhysiologyWaveform();
+        mgr->InitializeStatus();
+        mgr->InitializeRenderModification();
+        mgr->CreateTickPublisher();
+        mgr->CreatePhysiologyValuePublisher();
+        mgr->CreatePhysiologyWaveformPublisher();
+        mgr->CreateStatusPublisher();
+        mgr->CreateRenderModificationPublisher();
+
+        AMM::UUID id;
+        id.id(mgr->GenerateUuidString());
+        sink.reset(new DdsSink(*mgr, id));
+        // Give discovery a moment so the first ticks are not lost.
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    std::printf("%s: %d thread(s), %d nodes at %g Hz, burst %d x%d, %d s\n", mock ? "mock listener" : "DDS",
+                threads, options.nodes, options.tickHz, options.burstEvery, options.burstRounds, options.duration);
+
+    std::vector<std::unique_ptr<TrafficGenerator>> generators;
+    for (int i = 0; i < threads; ++i)
+    {
+        TrafficOptions threadOptions = options;
+        if (i > 0)
+        {
+            // DDS delivers each topic on one subscriber thread, and the listener relies on
+            // that for everything but physiology values. Extra threads only add values.
+            threadOptions.ticks = false;
+            threadOptions.waveforms = 0;
+            threadOptions.statusEvery = 0;
+            threadOptions.renderEvery = 0;
+        }
+        generators.emplace_back(new TrafficGenerator(threadOptions, *sink, i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (auto &generator : generators)
+    {
+        workers.emplace_back([&generator] { generator->run(stopRequested); });
+    }
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    TrafficGenerator::Counts total;
+    for (auto &generator : generators)
+    {
+        const TrafficGenerator::Counts &c = generator->counts();
+        total.ticks += c.ticks;
+        total.values += c.values;
+        total.statuses += c.statuses;
+        total.renderMods += c.renderMods;
+        total.waveformSamples += c.waveformSamples;
+    }
+    std::printf("\n%.2f s: %llu ticks, %llu values, %llu statuses, %llu render mods, %llu waveform samples, "
+                "%.0f samples/s\n",
+                seconds, static_cast<unsigned long long>(total.ticks), static_cast<unsigned long long>(total.values),
+                static_cast<unsigned long long>(total.statuses), static_cast<unsigned long long>(total.renderMods),
+                static_cast<unsigned long long>(total.waveformSamples), static_cast<double>(total.total()) / seconds);
+
+    if (mock)
+    {
+        PrintListenerStats();
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "TrafficGenerator.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace
+{
+    const char *const EngineNodes[] = {
+        "SIM_TIME",
+        "Cardiovascular_HeartRate",
+        "Cardiovascular_Arterial_Systolic_Pressure",
+        "Cardiovascular_Arterial_Diastolic_Pressure",
+        "Cardiovascular_Arterial_Mean_Pressure",
+        "Respiratory_Respiration_Rate",
+        "Respiratory_TidalVolume",
+        "Respiratory_EndTidalCarbonDioxide",
+        "BloodChemistry_Oxygen_Saturation",
+        "BloodChemistry_BloodPH",
+        "BloodChemistry_Hemaocrit",
+        "Energy_Core_Temperature",
+        "Substance_Sodium",
+        "Substance_Glucose_Concentration",
+        "MetabolicPanel_Potassium",
+        "MetabolicPanel_Chloride",
+    };
+
+    const char *const MonitorWaveforms[] = {"ECG_Lead_II", "Pleth", "Arterial_Pressure", "Capnogram"};
+
+    struct StatusSample
+    {
+        const char *module;
+        const char *capability;
+        const char *message;
+    };
+
+    const StatusSample Statuses[] = {
+        {"AMM_FluidManager", "air_supply", "14.7"},
+        {"AMM_FluidManager", "fluidics", ""},
+        {"Torso_Control", "blood_supply", ""},
+        {"Torso_Control", "clear_supply", ""},
+        {"AJAMS_Services", "battery-1", "87"},
+        {"AJAMS_Services", "battery-2", "64"},
+        {"AJAMS_Services", "ext_power", ""},
+        {"IVArm", "iv_detection", ""},
+    };
+
+    const char *const RenderTypes[] = {
+        "CONNECT_ECG", "CONNECT_PULSE_OX", "CONNECT_NIBP", "DETACH_ECG",
+        "ATTACH_TO_PATIENT", "DETACH_FROM_PATIENT", "PATIENT_COUGH",
+    };
+
+    template <typename T, std::size_t N>
+    constexpr std::size_t Count(const T (&)[N])
+    {
+        return N;
+    }
+}
+
+TrafficGenerator::TrafficGenerator(const TrafficOptions &options, TrafficSink &sink, int seed)
+    : m_options(options), m_sink(sink), m_seed(seed), m_names(NodeNames(options.nodes)),
+      m_waveformNames(WaveformNames(options.waveforms))
+{
+}
+
+std::vector<std::string> TrafficGenerator::NodeNames(int count)
+{
+    std::vector<std::string> names;
+    names.reserve(static_cast<std::size_t>(count));
+    for (int i = 0; i < count; ++i)
+    {
+        if (static_cast<std::size_t>(i) < Count(EngineNodes))
+        {
+            names.emplace_back(EngineNodes[i]);
+        }
+        else
+        {
+            names.push_back("Synthetic_Node_" + std::to_string(i));
+        }
+    }
+    return names;
+}
+
+std::vector<std::string> TrafficGenerator::WaveformNames(int count)
+{
+    std::vector<std::string> names;
+    for (int i = 0; i < count; ++i)
+    {
+        if (static_cast<std::size_t>(i) < Count(MonitorWaveforms))
+        {
+            names.emplace_back(MonitorWaveforms[i]);
+        }
+        else
+        {
+            names.push_back("Synthetic_Waveform_" + std::to_string(i));
+        }
+    }
+    return names;
+}
+
+void TrafficGenerator::publishWaveforms(int64_t frame, double time, double tickSeconds)
+{
+    AMM::PhysiologyWaveform sample;
+    sample.frame(frame);
+    sample.unit("mV");
+    for (std::size_t c = 0; c < m_waveformNames.size(); ++c)
+    {
+        sample.name(m_waveformNames[c]);
+        for (int i = 0; i < m_options.waveformSamples; ++i)
+        {
+            // A 1.2 Hz baseline with a narrow spike once per beat, like an ECG's R wave,
+            // so decimation has peaks to keep.
+            double t = time + tickSeconds * i / m_options.waveformSamples;
+            double phase = std::fmod(t * 1.2 + 0.1 * static_cast<double>(c), 1.0);
+            sample.value(0.1 * std::sin(2.0 * M_PI * t) + (phase < 0.02 ? 1.0 : 0.0));
+            m_sink.physiologyWaveform(sample);
+            ++m_counts.waveformSamples;
+        }
+    }
+}
+
+void TrafficGenerator::publishValues(int64_t frame, double time)
+{
+    AMM::PhysiologyValue value;
+    value.frame(frame);
+    for (std::size_t i = 0; i < m_names.size(); ++i)
+    {
+        // Slow waveform per node, phase-shifted so consecutive values differ.
+        value.name(m_names[i]);
+        value.value(100.0 + 20.0 * std::sin(time + static_cast<double>(i + m_seed)));
+        m_sink.physiologyValue(value);
+        ++m_counts.values;
+    }
+}
+
+void TrafficGenerator::run(const std::atomic<bool> &stop)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::seconds(m_options.duration);
+    Clock::duration period = m_options.tickHz > 0
+                                 ? std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(1.0 / m_options.tickHz))
+                                 : Clock::duration::zero();
+    Clock::time_point due = start;
+
+    for (int64_t frame = 1; !stop.load(std::memory_order_relaxed); ++frame)
+    {
+        Clock::time_point now = Clock::now();
+        if (now >= end)
+        {
+            break;
+        }
+        if (period > Clock::duration::zero())
+        {
+            // Fixed schedule: a slow sink makes the generator catch up, not drift.
+            if (now < due)
+            {
+                std::this_thread::sleep_until(due);
+            }
+            due += period;
+        }
+
+        double time = std::chrono::duration<double>(Clock::now() - start).count();
+        if (m_options.ticks)
+        {
+            AMM::Tick tick;
+            tick.frame(frame);
+            tick.time(static_cast<float>(time));
+            m_sink.tick(tick);
+            ++m_counts.ticks;
+        }
+
+        publishValues(frame, time);
+        publishWaveforms(frame, time, m_options.tickHz > 0 ? 1.0 / m_options.tickHz : 0.0);
+        if (m_options.burstEvery > 0 && frame % m_options.burstEvery == 0)
+        {
+            for (int round = 0; round < m_options.burstRounds; ++round)
+            {
+                publishValues(frame, time);
+            }
+        }
+
+        if (m_options.statusEvery > 0 && frame % m_options.statusEvery == 0)
+        {
+            const StatusSample &sample = Statuses[(frame / m_options.statusEvery) % Count(Statuses)];
+            AMM::Status status;
+            status.module_name(sample.module);
+            status.capability(sample.capability);
+            status.message(sample.message);
+            status.value(AMM::StatusValue::OPERATIONAL);
+            m_sink.status(status);
+            ++m_counts.statuses;
+        }
+
+        if (m_options.renderEvery > 0 && frame % m_options.renderEvery == 0)
+        {
+            const char *type = RenderTypes[(frame / m_options.renderEvery) % Count(RenderTypes)];
+            AMM::RenderModification mod;
+            mod.type(type);
+            mod.data(std::string("<RenderModification type=\"") + type + "\"/>");
+            m_sink.renderModification(mod);
+            ++m_counts.renderMods;
+        }
+    }
+}
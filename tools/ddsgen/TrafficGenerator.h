@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "amm_std.h"
+
+/// Receives generated samples: DDS publishers, or a listener called in process.
+class TrafficSink
+{
+public:
+    virtual ~TrafficSink() = default;
+
+    virtual void tick(AMM::Tick &tick) = 0;
+    virtual void physiologyValue(AMM::PhysiologyValue &value) = 0;
+    virtual void physiologyWaveform(AMM::PhysiologyWaveform &sample) = 0;
+    virtual void status(AMM::Status &status) = 0;
+    virtual void renderModification(AMM::RenderModification &mod) = 0;
+};
+
+/// Shape of the generated traffic.
+struct TrafficOptions
+{
+    int nodes = 200;           ///< Physiology values published per tick.
+    double tickHz = 50.0;      ///< Ticks per second; 0 = as fast as possible.
+    int statusEvery = 50;      ///< Ticks between status samples (0 = none).
+    int renderEvery = 250;     ///< Ticks between render modifications (0 = none).
+    int burstEvery = 0;        ///< Ticks between bursts (0 = none).
+    int burstRounds = 10;      ///< Extra rounds of every node published in a burst.
+    int waveforms = 0;         ///< Waveform channels.
+    int waveformSamples = 10;  ///< Samples per channel per tick (500 Hz at 50 ticks/s).
+    int duration = 30;         ///< Seconds.
+    bool ticks = true;         ///< Publish Tick samples.
+};
+
+/// Engine-like sample stream: every tick publishes a Tick followed by one value per node
+/// and a block of samples per waveform channel, with periodic status and render
+/// modification samples. A burst republishes all nodes
+/// several times back to back, as an engine catching up after a stall does.
+class TrafficGenerator
+{
+public:
+    struct Counts
+    {
+        uint64_t ticks = 0;
+        uint64_t values = 0;
+        uint64_t statuses = 0;
+        uint64_t renderMods = 0;
+        uint64_t waveformSamples = 0;
+
+        uint64_t total() const { return ticks + values + statuses + renderMods + waveformSamples; }
+    };
+
+    TrafficGenerator(const TrafficOptions &options, TrafficSink &sink, int seed = 0);
+
+    /// Publishes until the duration elapses or stop is set.
+    void run(const std::atomic<bool> &stop);
+
+    const Counts &counts() const { return m_counts; }
+
+    /// Node names used: real engine paths first, then synthetic ones up to the count.
+    static std::vector<std::string> NodeNames(int count);
+
+    /// Waveform channel names: common monitor channels first, then synthetic ones.
+    static std::vector<std::string> WaveformNames(int count);
+
+private:
+    void publishValues(int64_t frame, double time);
+    void publishWaveforms(int64_t frame, double time, double tickSeconds);
+
+    TrafficOptions m_options;
+    TrafficSink &m_sink;
+    int m_seed;
+    std::vector<std::string> m_names;
+    std::vector<std::string> m_waveformNames;
+    Counts m_counts;
+};
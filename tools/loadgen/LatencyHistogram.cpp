@@ -0,0 +1,83 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    int Log2(uint64_t value)
+    {
+        return 63 - __builtin_clzll(value);
+    }
+}
+
+// Values below SubCount get one bucket each. Above that, each power of two is split into
+// HalfCount buckets: shift s covers [SubCount << (s - 1), SubCount << s) in steps of 2^s.
+LatencyHistogram::LatencyHistogram()
+    : m_counts(SubCount + (64 - SubBits) * HalfCount, 0)
+{
+}
+
+std::size_t LatencyHistogram::indexOf(uint64_t ns)
+{
+    if (ns < SubCount)
+    {
+        return static_cast<std::size_t>(ns);
+    }
+    int shift = Log2(ns) - SubBits + 1;
+    uint64_t top = ns >> shift;
+    return static_cast<std::size_t>(SubCount + (shift - 1) * HalfCount + (top - HalfCount));
+}
+
+uint64_t LatencyHistogram::upperBound(std::size_t index)
+{
+    if (index < SubCount)
+    {
+        return index;
+    }
+    std::size_t offset = index - SubCount;
+    int shift = static_cast<int>(offset / HalfCount) + 1;
+    uint64_t top = HalfCount + offset % HalfCount;
+    return ((top + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    ++m_counts[indexOf(ns)];
+    ++m_count;
+    m_sum += ns;
+    m_min = std::min(m_min, ns);
+    m_max = std::max(m_max, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (std::size_t i = 0; i < m_counts.size(); ++i)
+    {
+        m_counts[i] += other.m_counts[i];
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(m_count)));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_counts.size(); ++i)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+        {
+            return std::min(upperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Log-linear histogram of latencies in nanoseconds. Values are kept to within 1/128 of
+/// their magnitude, from 1 ns up to the full 64-bit range, in a fixed table of counts.
+/// Single writer; merge per-thread histograms before reading percentiles.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t min() const { return m_count > 0 ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count > 0 ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+    /// Smallest recorded bucket bound at or below which p percent of the values fall.
+    uint64_t percentile(double p) const;
+
+private:
+    static constexpr int SubBits = 8;
+    static constexpr uint64_t SubCount = uint64_t(1) << SubBits;
+    static constexpr uint64_t HalfCount = SubCount / 2;
+
+    static std::size_t indexOf(uint64_t ns);
+    static uint64_t upperBound(std::size_t index);
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+};
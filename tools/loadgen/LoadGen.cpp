@@ -0,0 +1,600 @@
+/// amm_rest_loadgen: drives a running REST adapter with a weighted mix of routes and
+/// reports throughput and latency percentiles.
+///
+/// In the default open-loop mode every connection sends on a fixed schedule and latency
+/// is measured from the time a request was due, not from when it was actually sent. A
+/// stalled adapter therefore shows up as queueing delay in the percentiles instead of
+/// quietly lowering the request rate (coordinated omission).
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        int port = 9080;
+        int connections = 16;
+        double rate = 1000.0; ///< Requests per second over all connections; 0 = closed loop.
+        int duration = 30;
+        int warmup = 5;
+        std::string mix = "nodes=70,node=20,command=5,events=5";
+        std::string node = "Cardiovascular_HeartRate";
+        std::string command = "%5BACT%5DLOADGEN";
+        std::string json;
+    };
+
+    struct Route
+    {
+        std::string name;
+        std::string request;
+        int weight;
+    };
+
+    /// Counters of one connection; merged after the run.
+    struct Stats
+    {
+        explicit Stats(std::size_t routes) : perRoute(routes) {}
+
+        LatencyHistogram all;
+        std::vector<LatencyHistogram> perRoute;
+        uint64_t status[6] = {}; ///< By status class: [2] = 2xx ... [5] = 5xx, [0] = other.
+        uint64_t errors = 0;
+        uint64_t bytes = 0;
+    };
+
+    void ShowUsage(const std::string &name)
+    {
+        std::cerr << "Usage: " << name << " <option(s)>"
+                  << "\nOptions:\n"
+                  << "\t-host <addr>\t\tAdapter address (default 127.0.0.1)\n"
+                  << "\t-port <n>\t\tAdapter port (default 9080)\n"
+                  << "\t-c <n>\t\t\tConnections (default 16)\n"
+                  << "\t-rate <n>\t\tRequests per second over all connections, 0 = as fast as\n"
+                  << "\t\t\t\tpossible without coordinated-omission correction (default 1000)\n"
+                  << "\t-duration <s>\t\tMeasured run time (default 30)\n"
+                  << "\t-warmup <s>\t\tUnmeasured run time before that (default 5)\n"
+                  << "\t-mix <route=weight,...>\tRoutes: nodes, node, command, events\n"
+                  << "\t\t\t\t(default nodes=70,node=20,command=5,events=5)\n"
+                  << "\t-node <name>\t\tNode requested by the node route\n"
+                  << "\t-command <text>\t\tURL-encoded command sent by the command route\n"
+                  << "\t-json <path>\t\tAlso write the results as JSON\n"
+                  << std::endl;
+    }
+
+    std::string Get(const Options &options, const std::string &path)
+    {
+        return "GET " + path + " HTTP/1.1\r\nHost: " + options.host + ":" + std::to_string(options.port) +
+               "\r\nUser-Agent: amm_rest_loadgen\r\n\r\n";
+    }
+
+    bool ParseMix(const Options &options, std::vector<Route> &routes)
+    {
+        std::stringstream mix(options.mix);
+        std::string item;
+        while (std::getline(mix, item, ','))
+        {
+            std::size_t eq = item.find('=');
+            std::string name = item.substr(0, eq);
+            int weight = eq == std::string::npos ? 1 : std::atoi(item.c_str() + eq + 1);
+            if (weight <= 0)
+            {
+                continue;
+            }
+            std::string path;
+            if (name == "nodes")
+            {
+                path = "/nodes";
+            }
+            else if (name == "node")
+            {
+                path = "/node/" + options.node;
+            }
+            else if (name == "command")
+            {
+                path = "/command/" + options.command;
+            }
+            else if (name == "events")
+            {
+                path = "/events";
+            }
+            else
+            {
+                std::cerr << "Unknown route in mix: " << name << std::endl;
+                return false;
+            }
+            routes.push_back({name, Get(options, path), weight});
+        }
+        return !routes.empty();
+    }
+
+    /// One keep-alive HTTP/1.1 connection with blocking I/O.
+    class Connection
+    {
+    public:
+        explicit Connection(const sockaddr_in &address) : m_address(address) {}
+        ~Connection() { close(); }
+
+        /// Sends the request and reads the whole response. Returns the status code, or 0 on
+        /// a transport error (the connection is then reopened on the next call).
+        int exchange(const std::string &request, uint64_t &bytes)
+        {
+            bool reused = m_fd >= 0;
+            if (!reused && !open())
+            {
+                return 0;
+            }
+            int status = sendAll(request) ? readResponse(bytes) : 0;
+            if (status == 0 && reused && m_buffer.empty())
+            {
+                // The server closed the idle keep-alive connection; retry once on a new one.
+                close();
+                if (!open())
+                {
+                    return 0;
+                }
+                status = sendAll(request) ? readResponse(bytes) : 0;
+            }
+            if (status == 0 || m_closeAfter)
+            {
+                close();
+            }
+            return status;
+        }
+
+    private:
+        bool open()
+        {
+            m_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (m_fd < 0)
+            {
+                return false;
+            }
+            int one = 1;
+            ::setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (::connect(m_fd, reinterpret_cast<const sockaddr *>(&m_address), sizeof(m_address)) < 0)
+            {
+                close();
+                return false;
+            }
+            m_buffer.clear();
+            return true;
+        }
+
+        void close()
+        {
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+                m_fd = -1;
+            }
+        }
+
+        bool sendAll(const std::string &data)
+        {
+            std::size_t sent = 0;
+            while (sent < data.size())
+            {
+                ssize_t n = ::send(m_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return false;
+                }
+                sent += static_cast<std::size_t>(n);
+            }
+            return true;
+        }
+
+        /// Appends at least one more byte to the buffer.
+        bool fill()
+        {
+            char chunk[16384];
+            while (true)
+            {
+                ssize_t n = ::recv(m_fd, chunk, sizeof(chunk), 0);
+                if (n < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (n <= 0)
+                {
+                    return false;
+                }
+                m_buffer.append(chunk, static_cast<std::size_t>(n));
+                return true;
+            }
+        }
+
+        /// Reads until the buffer holds a line ending at or after from; returns its offset.
+        bool readLine(std::size_t from, std::size_t &eol)
+        {
+            while ((eol = m_buffer.find("\r\n", from)) == std::string::npos)
+            {
+                if (!fill())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool readBytes(std::size_t count)
+        {
+            while (m_buffer.size() < count)
+            {
+                if (!fill())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        int readResponse(uint64_t &bytes)
+        {
+            std::size_t headerEnd;
+            while ((headerEnd = m_buffer.find("\r\n\r\n")) == std::string::npos)
+            {
+                if (!fill())
+                {
+                    return 0;
+                }
+            }
+
+            int status = 0;
+            if (m_buffer.compare(0, 5, "HTTP/") == 0)
+            {
+                std::size_t space = m_buffer.find(' ');
+                if (space != std::string::npos && space < headerEnd)
+                {
+                    status = std::atoi(m_buffer.c_str() + space + 1);
+                }
+            }
+            if (status == 0)
+            {
+                return 0;
+            }
+
+            std::string headers = m_buffer.substr(0, headerEnd);
+            std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+            m_closeAfter = headers.find("\r\nconnection: close") != std::string::npos ||
+                           (headers.compare(0, 8, "http/1.0") == 0 &&
+                            headers.find("\r\nconnection: keep-alive") == std::string::npos);
+            bool chunked = headers.find("\r\ntransfer-encoding: chunked") != std::string::npos;
+            std::size_t length = 0;
+            std::size_t lengthAt = headers.find("\r\ncontent-length:");
+            if (lengthAt != std::string::npos)
+            {
+                length = std::strtoull(headers.c_str() + lengthAt + 17, nullptr, 10);
+            }
+
+            m_buffer.erase(0, headerEnd + 4);
+            if (chunked)
+            {
+                std::size_t total = 0;
+                while (true)
+                {
+                    std::size_t eol;
+                    if (!readLine(0, eol))
+                    {
+                        return 0;
+                    }
+                    std::size_t size = std::strtoull(m_buffer.c_str(), nullptr, 16);
+                    m_buffer.erase(0, eol + 2);
+                    if (!readBytes(size + 2))
+                    {
+                        return 0;
+                    }
+                    m_buffer.erase(0, size + 2);
+                    total += size;
+                    if (size == 0)
+                    {
+                        break;
+                    }
+                }
+                bytes += total;
+            }
+            else
+            {
+                if (!readBytes(length))
+                {
+                    return 0;
+                }
+                m_buffer.erase(0, length);
+                bytes += length;
+            }
+            return status;
+        }
+
+        sockaddr_in m_address;
+        int m_fd = -1;
+        bool m_closeAfter = false;
+        std::string m_buffer;
+    };
+
+    /// Runs one connection until end, recording the requests due at or after measureFrom.
+    void RunConnection(int index, const Options &options, const sockaddr_in &address,
+                       const std::vector<Route> &routes, Clock::time_point start, Clock::time_point measureFrom,
+                       Clock::time_point end, Stats &stats)
+    {
+        std::vector<int> weights;
+        for (const Route &route : routes)
+        {
+            weights.push_back(route.weight);
+        }
+        std::mt19937 random(static_cast<unsigned>(index) * 7919u + 1u);
+        std::discrete_distribution<std::size_t> pick(weights.begin(), weights.end());
+
+        Connection connection(address);
+        bool openLoop = options.rate > 0;
+        auto interval = openLoop ? std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(options.connections / options.rate))
+                                 : Clock::duration::zero();
+        // Spread the connections' schedules evenly over one interval.
+        Clock::time_point due = start + interval * index / options.connections;
+
+        while (true)
+        {
+            Clock::time_point now = Clock::now();
+            if (openLoop)
+            {
+                if (due >= end)
+                {
+                    break;
+                }
+                if (now < due)
+                {
+                    std::this_thread::sleep_until(due);
+                }
+            }
+            else
+            {
+                if (now >= end)
+                {
+                    break;
+                }
+                due = now;
+            }
+
+            std::size_t route = pick(random);
+            uint64_t bytes = 0;
+            int status = connection.exchange(routes[route].request, bytes);
+            Clock::time_point done = Clock::now();
+
+            if (due >= measureFrom)
+            {
+                if (status == 0)
+                {
+                    ++stats.errors;
+                }
+                else
+                {
+                    uint64_t ns = static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(done - due).count());
+                    stats.all.record(ns);
+                    stats.perRoute[route].record(ns);
+                    int statusClass = status / 100;
+                    ++stats.status[statusClass >= 2 && statusClass <= 5 ? statusClass : 0];
+                    stats.bytes += bytes;
+                }
+            }
+            if (status == 0)
+            {
+                // Don't spin on a refused connection.
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            due += interval;
+        }
+    }
+
+    double Ms(uint64_t ns)
+    {
+        return static_cast<double>(ns) / 1e6;
+    }
+
+    void PrintLatency(const std::string &name, const LatencyHistogram &h)
+    {
+        std::printf("  %-10s %10llu  %9.3f  %9.3f  %9.3f  %9.3f  %9.3f  %9.3f\n", name.c_str(),
+                    static_cast<unsigned long long>(h.count()), Ms(h.percentile(50)), Ms(h.percentile(90)),
+                    Ms(h.percentile(99)), Ms(h.percentile(99.9)), Ms(h.max()), Ms(static_cast<uint64_t>(h.mean())));
+    }
+
+    void WriteLatencyJson(std::ostream &out, const LatencyHistogram &h)
+    {
+        out << "{\"count\":" << h.count() << ",\"mean_ms\":" << Ms(static_cast<uint64_t>(h.mean()))
+            << ",\"p50_ms\":" << Ms(h.percentile(50)) << ",\"p90_ms\":" << Ms(h.percentile(90))
+            << ",\"p99_ms\":" << Ms(h.percentile(99)) << ",\"p999_ms\":" << Ms(h.percentile(99.9))
+            << ",\"max_ms\":" << Ms(h.max()) << "}";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" || arg == "--help")
+        {
+            ShowUsage(argv[0]);
+            return 0;
+        }
+        else if (arg == "-host" && hasValue)
+        {
+            options.host = argv[++i];
+        }
+        else if (arg == "-port" && hasValue)
+        {
+            options.port = std::atoi(argv[++i]);
+        }
+        else if (arg == "-c" && hasValue)
+        {
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-rate" && hasValue)
+        {
+            options.rate = std::max(0.0, std::atof(argv[++i]));
+        }
+        else if (arg == "-duration" && hasValue)
+        {
+            options.duration = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "-warmup" && hasValue)
+        {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (arg == "-mix" && hasValue)
+        {
+            options.mix = argv[++i];
+        }
+        else if (arg == "-node" && hasValue)
+        {
+            options.node = argv[++i];
+        }
+        else if (arg == "-command" && hasValue)
+        {
+            options.command = argv[++i];
+        }
+        else if (arg == "-json" && hasValue)
+        {
+            options.json = argv[++i];
+        }
+        else
+        {
+            ShowUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Route> routes;
+    if (!ParseMix(options, routes))
+    {
+        std::cerr << "Empty or invalid route mix: " << options.mix << std::endl;
+        return 1;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *resolved = nullptr;
+    if (getaddrinfo(options.host.c_str(), nullptr, &hints, &resolved) != 0 || resolved == nullptr)
+    {
+        std::cerr << "Unable to resolve " << options.host << std::endl;
+        return 1;
+    }
+    sockaddr_in address = *reinterpret_cast<sockaddr_in *>(resolved->ai_addr);
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    freeaddrinfo(resolved);
+
+    std::printf("%s:%d, %d connections, %s, %d s warmup + %d s, mix %s\n", options.host.c_str(), options.port,
+                options.connections,
+                options.rate > 0 ? (std::to_string(static_cast<long>(options.rate)) + " req/s").c_str()
+                                 : "closed loop",
+                options.warmup, options.duration, options.mix.c_str());
+
+    std::vector<std::unique_ptr<Stats>> stats;
+    for (int i = 0; i < options.connections; ++i)
+    {
+        stats.emplace_back(new Stats(routes.size()));
+    }
+
+    Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+    Clock::time_point measureFrom = start + std::chrono::seconds(options.warmup);
+    Clock::time_point end = measureFrom + std::chrono::seconds(options.duration);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; ++i)
+    {
+        threads.emplace_back(RunConnection, i, std::cref(options), std::cref(address), std::cref(routes), start,
+                             measureFrom, end, std::ref(*stats[i]));
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+
+    Stats total(routes.size());
+    for (auto &s : stats)
+    {
+        total.all.merge(s->all);
+        for (std::size_t r = 0; r < routes.size(); ++r)
+        {
+            total.perRoute[r].merge(s->perRoute[r]);
+        }
+        for (int c = 0; c < 6; ++c)
+        {
+            total.status[c] += s->status[c];
+        }
+        total.errors += s->errors;
+        total.bytes += s->bytes;
+    }
+
+    double seconds = static_cast<double>(options.duration);
+    double throughput = static_cast<double>(total.all.count()) / seconds;
+    std::printf("\nThroughput: %.1f req/s, %.2f MiB/s\n", throughput,
+                static_cast<double>(total.bytes) / seconds / (1024.0 * 1024.0));
+    std::printf("Responses: 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, other %llu, transport errors %llu\n",
+                static_cast<unsigned long long>(total.status[2]), static_cast<unsigned long long>(total.status[3]),
+                static_cast<unsigned long long>(total.status[4]), static_cast<unsigned long long>(total.status[5]),
+                static_cast<unsigned long long>(total.status[0]), static_cast<unsigned long long>(total.errors));
+    if (options.rate > 0 && throughput < 0.95 * options.rate)
+    {
+        std::printf("Warning: target rate not reached; add connections or lower -rate\n");
+    }
+    std::printf("\nLatency (ms)      count        p50        p90        p99      p99.9        max       mean\n");
+    PrintLatency("all", total.all);
+    for (std::size_t r = 0; r < routes.size(); ++r)
+    {
+        PrintLatency(routes[r].name, total.perRoute[r]);
+    }
+
+    if (!options.json.empty())
+    {
+        std::ofstream out(options.json);
+        out << "{\"connections\":" << options.connections << ",\"rate\":" << options.rate
+            << ",\"duration_s\":" << options.duration << ",\"mix\":\"" << options.mix << "\""
+            << ",\"throughput_rps\":" << throughput << ",\"bytes\":" << total.bytes
+            << ",\"status\":{\"2xx\":" << total.status[2] << ",\"3xx\":" << total.status[3]
+            << ",\"4xx\":" << total.status[4] << ",\"5xx\":" << total.status[5] << ",\"other\":" << total.status[0]
+            << "},\"errors\":" << total.errors << ",\"latency\":";
+        WriteLatencyJson(out, total.all);
+        out << ",\"routes\":{";
+        for (std::size_t r = 0; r < routes.size(); ++r)
+        {
+            out << (r > 0 ? "," : "") << "\"" << routes[r].name << "\":";
+            WriteLatencyJson(out, total.perRoute[r]);
+        }
+        out << "}}\n";
+    }
+    return 0;
+}